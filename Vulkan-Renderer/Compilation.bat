@@ -1,5 +1,35 @@
 @echo off
-cd C:\Users\Download\work_VS\Projects\myVulkan
-C:\Users\000mr\Desktop\Vulkan\SDK\Bin\glslc.exe shader.vert -o vert.spv
-C:\Users\000mr\Desktop\Vulkan\SDK\Bin\glslc.exe shader.frag -o frag.spv
-pause
\ No newline at end of file
+rem  Vulkan_Temp_2 еɫ .spv Ƕõ .spv.inc
+rem Ŀûйϵͳ޸ɫҪֶбű±
+setlocal
+
+if "%VULKAN_SDK%"=="" (
+    echo VULKAN_SDK is not set, install the Vulkan SDK first
+    pause
+    exit /b 1
+)
+
+set GLSLC="%VULKAN_SDK%\Bin\glslc.exe"
+set SPIRV_VAL="%VULKAN_SDK%\Bin\spirv-val.exe"
+
+rem ԱűĿ¼ǰĿ¼
+cd /d "%~dp0Vulkan_Temp_2" || exit /b 1
+
+call :compile shader.vert vert || goto failed
+call :compile shader.frag frag || goto failed
+
+echo Shaders compiled and validated
+pause
+exit /b 0
+
+:failed
+echo Shader compilation failed
+pause
+exit /b 1
+
+rem  У飬УʧʱɾǶδͨУĴ
+:compile
+%GLSLC% %1 -o %2.spv || exit /b 1
+%SPIRV_VAL% %2.spv || (del %2.spv %2.spv.inc 2>nul & exit /b 1)
+%GLSLC% %1 -mfmt=num -o %2.spv.inc || exit /b 1
+exit /b 0
@@ -0,0 +1,166 @@
+/// <summary>
+/// 
+///  屏障批处理 | 同步2 | 精确的阶段与访问类型
+/// 
+/// </summary>
+
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 排队的屏障，在下一条需要它们的命令之前通过一个依赖信息一次记录
+struct BarrierBatcher
+{
+    vector<VkMemoryBarrier2> memoryBarriers{}; // 最多一个，排队时合并
+    vector<VkBufferMemoryBarrier2> bufferBarriers{};
+    vector<VkImageMemoryBarrier2> imageBarriers{};
+};
+
+// ##############################################################
+
+VkPipelineStageFlags toLegacyStages(VkPipelineStageFlags2 stages, VkPipelineStageFlags emptyStage)
+{
+    // 同步2 新增的细分阶段映射回包含它们的旧阶段，其余阶段的位相同
+    VkPipelineStageFlags legacy = static_cast<VkPipelineStageFlags>(stages & 0xFFFFFFFFull);
+
+    if (stages & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT)) legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT)) legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) legacy |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+
+    // 旧接口不接受空的阶段
+    return legacy != 0 ? legacy : emptyStage;
+}
+
+VkAccessFlags toLegacyAccess(VkAccessFlags2 access)
+{
+    VkAccessFlags legacy = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+
+    if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) legacy |= VK_ACCESS_SHADER_READ_BIT;
+    if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+
+    return legacy;
+}
+
+bool hasQueuedBarriers(const BarrierBatcher& batcher)
+{
+    return !batcher.memoryBarriers.empty() || !batcher.bufferBarriers.empty() || !batcher.imageBarriers.empty();
+}
+
+void queueMemoryBarrier(BarrierBatcher& batcher, VkPipelineStageFlags2 srcStageMask, VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask)
+{
+    // 全局内存屏障合并为一个
+    if (batcher.memoryBarriers.empty())
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        batcher.memoryBarriers.push_back(barrier);
+    }
+
+    VkMemoryBarrier2& barrier = batcher.memoryBarriers[0];
+    barrier.srcStageMask |= srcStageMask;
+    barrier.srcAccessMask |= srcAccessMask;
+    barrier.dstStageMask |= dstStageMask;
+    barrier.dstAccessMask |= dstAccessMask;
+}
+
+void queueBufferBarrier(BarrierBatcher& batcher, VkBufferMemoryBarrier2 barrier)
+{
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    batcher.bufferBarriers.push_back(barrier);
+}
+
+void queueImageBarrier(BarrierBatcher& batcher, VkImageMemoryBarrier2 barrier)
+{
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    batcher.imageBarriers.push_back(barrier);
+}
+
+void recordLegacyBarriers(const BarrierBatcher& batcher, VkCommandBuffer commandBuffer)
+{
+    // 不支持同步2 时转换为一次 vkCmdPipelineBarrier，阶段取所有屏障的并集
+    VkPipelineStageFlags2 srcStages = 0;
+    VkPipelineStageFlags2 dstStages = 0;
+
+    vector<VkMemoryBarrier> memoryBarriers(batcher.memoryBarriers.size());
+    for (size_t i = 0; i < memoryBarriers.size(); i++)
+    {
+        const VkMemoryBarrier2& barrier = batcher.memoryBarriers[i];
+        srcStages |= barrier.srcStageMask;
+        dstStages |= barrier.dstStageMask;
+
+        memoryBarriers[i].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+        memoryBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+    }
+
+    vector<VkBufferMemoryBarrier> bufferBarriers(batcher.bufferBarriers.size());
+    for (size_t i = 0; i < bufferBarriers.size(); i++)
+    {
+        const VkBufferMemoryBarrier2& barrier = batcher.bufferBarriers[i];
+        srcStages |= barrier.srcStageMask;
+        dstStages |= barrier.dstStageMask;
+
+        bufferBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+        bufferBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+        bufferBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        bufferBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        bufferBarriers[i].buffer = barrier.buffer;
+        bufferBarriers[i].offset = barrier.offset;
+        bufferBarriers[i].size = barrier.size;
+    }
+
+    vector<VkImageMemoryBarrier> imageBarriers(batcher.imageBarriers.size());
+    for (size_t i = 0; i < imageBarriers.size(); i++)
+    {
+        const VkImageMemoryBarrier2& barrier = batcher.imageBarriers[i];
+        srcStages |= barrier.srcStageMask;
+        dstStages |= barrier.dstStageMask;
+
+        imageBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+        imageBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+        imageBarriers[i].oldLayout = barrier.oldLayout;
+        imageBarriers[i].newLayout = barrier.newLayout;
+        imageBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        imageBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        imageBarriers[i].image = barrier.image;
+        imageBarriers[i].subresourceRange = barrier.subresourceRange;
+    }
+
+    vkCmdPipelineBarrier
+    (
+        commandBuffer,
+        toLegacyStages(srcStages, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT), toLegacyStages(dstStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+        0,
+        static_cast<uint32_t>(memoryBarriers.size()), memoryBarriers.data(),
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+    );
+}
+
+void flushBarriers(BarrierBatcher& batcher, VkCommandBuffer commandBuffer)
+{
+    if (!hasQueuedBarriers(batcher)) return;
+
+    if (mySynchronization2Enabled)
+    {
+        // 每个屏障保留自己的阶段，不同资源之间不会互相等待
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(batcher.memoryBarriers.size());
+        dependencyInfo.pMemoryBarriers = batcher.memoryBarriers.data();
+        dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(batcher.bufferBarriers.size());
+        dependencyInfo.pBufferMemoryBarriers = batcher.bufferBarriers.data();
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(batcher.imageBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = batcher.imageBarriers.data();
+
+        myCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+    else recordLegacyBarriers(batcher, commandBuffer);
+
+    batcher.memoryBarriers.clear();
+    batcher.bufferBarriers.clear();
+    batcher.imageBarriers.clear();
+}
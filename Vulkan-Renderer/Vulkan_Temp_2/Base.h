@@ -1,16 +1,81 @@
 /// <summary>
 /// 
-///  ȫֱ
+///  基本全局变量
 /// 
 /// </summary>
 
+#include <thread>
 #include <vector>
+// x86 上用 SSE2 批量转换数据
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
 using namespace std;
 
 const uint32_t const_width = 800;
 const uint32_t const_height = 600;
 const uint32_t const_maxFrames = 3;
 
+// 设备至少需要的 Vulkan 版本（时间线信号量），实例按可选功能请求更高的版本
+const uint32_t const_apiVersion = VK_API_VERSION_1_2;
+const uint32_t const_maxApiVersion = VK_API_VERSION_1_3;
+
+// 设备支持动态渲染时直接在交换链图像上渲染，不创建渲染通道与帧缓冲区
+const bool const_enableDynamicRendering = true;
+
+// 设备支持同步2 时屏障使用精确的细分阶段，否则转换为旧接口
+const bool const_enableSynchronization2 = true;
+
+// 场景、管线与交换链都没有变化时重复提交上一次录制的命令缓冲区
+const bool const_enableCommandBufferReuse = true;
+
+// 每帧统一缓冲环形区的切片数量，每个通道的观察与投影矩阵一个切片
+// 每个物体的数据通过推送常量写入，不占用环形区
+const uint32_t const_uniformRingSlices = 16;
+
+// 推送常量对两个着色器阶段都可见
+const VkShaderStageFlags const_pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+// 从内存块中子分配得到的内存 (见 Memory.h)
+struct MemoryBlock;
+struct MemoryAllocation
+{
+    VkDeviceMemory memory = nullptr; // 所在的设备内存
+    VkDeviceSize offset = 0; // 在设备内存中的偏移
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // 主机可见时的映射地址
+    MemoryBlock* block = nullptr; // 所属内存块，独立分配时为空
+    uint32_t memoryTypeIndex = 0;
+};
+
+// 一组工作线程，析构时通知停止并等待退出
+// 初始化或主循环抛出异常时，线程在静态析构中被回收，而不是留下可连接的线程导致 terminate
+// 需要定义在线程使用的同步对象之后，保证先于它们析构
+struct WorkerThreads
+{
+    vector<thread> threads{};
+    void (*stop)() = nullptr; // 通知所有线程退出
+
+    ~WorkerThreads() { join(); }
+
+    void join()
+    {
+        if (threads.empty()) return;
+
+        stop();
+        for (auto& worker : threads) worker.join();
+        threads.clear();
+    }
+};
+
+// 每次绘制的推送常量，不经过缓冲区内存
+struct PushConstants
+{
+    glm::mat4 model;
+    uint32_t materialIndex; // 子网格的材质
+};
+
 uint32_t currentFrame = 0;
 
 GLFWwindow* myWindow = nullptr;
@@ -19,9 +84,23 @@ VkSurfaceKHR mySurface = nullptr;
 
 VkPhysicalDevice myPhysicalDevice = VK_NULL_HANDLE;
 VkDevice myDevice = nullptr;
+uint32_t myDeviceApiVersion = 0; // 设备与实例版本中较低的一个
+
+// 动态渲染，1.3 之前通过拓展获取函数
+bool myDynamicRenderingEnabled = false;
+PFN_vkCmdBeginRenderingKHR myCmdBeginRendering = nullptr;
+PFN_vkCmdEndRenderingKHR myCmdEndRendering = nullptr;
+
+// 同步2，1.3 之前通过拓展获取函数
+bool mySynchronization2Enabled = false;
+PFN_vkCmdPipelineBarrier2KHR myCmdPipelineBarrier2 = nullptr;
 
 VkQueue myGraphicsQueue = nullptr;
 VkQueue myPresentQueue = nullptr;
+VkQueue myTransferQueue = nullptr; // 没有专用传输队列组时与图形队列相同
+
+uint32_t myGraphicsQueueFamily = 0;
+uint32_t myTransferQueueFamily = 0;
 
 VkSwapchainKHR mySwapChain = nullptr;
 VkFormat mySwapChainImageFormat{};
@@ -31,8 +110,8 @@ vector<VkImage> mySwapChainImages{};
 vector<VkImageView> mySwapChainImageViews{};
 
 vector<VkDescriptorSet> descriptorSets{};
-VkDescriptorPool myDescriptorPool = nullptr;
 VkDescriptorSetLayout myDescriptorSetLayout = nullptr;
+VkDescriptorUpdateTemplate myDescriptorUpdateTemplate = nullptr;
 
 VkRenderPass myRenderPass = nullptr;
 VkPipelineLayout myPipelineLayout = nullptr;
@@ -41,24 +120,33 @@ VkPipeline myGraphicsPipeline = nullptr;
 
 vector<VkFramebuffer> mySwapChainFramebuffers{};
 
-VkCommandPool myCommandPool = nullptr;
+vector<VkCommandPool> myCommandPools{}; // 每帧一个
 vector<VkCommandBuffer> myCommandBuffers{};
 
 vector<VkSemaphore> myImageAvailableSemaphores{};
 vector<VkSemaphore> myRenderFinishedSemaphores{};
-vector<VkFence> myInFlightFences{};
 
 VkBuffer myVertexBuffer = nullptr;
-VkDeviceMemory myVertexBufferMemory = nullptr;
+MemoryAllocation myVertexBufferMemory{};
 
 VkBuffer myIndexBuffer = nullptr;
-VkDeviceMemory myIndexBufferMemory = nullptr;
+MemoryAllocation myIndexBufferMemory{};
 
+// 每帧一个统一缓冲环形区，通过动态偏移访问当前帧的切片
 vector<VkBuffer> myUniformBuffers{};
-vector<VkDeviceMemory> myUniformBuffersMemory{};
+vector<MemoryAllocation> myUniformBuffersMemory{};
 vector<void*> myUniformBuffersMapped{};
 
+VkDeviceSize myUniformAlignment = 0; // minUniformBufferOffsetAlignment 对齐后的切片间隔
+VkDeviceSize myUniformRingSize = 0;
+VkDeviceSize myUniformRingHead = 0; // 当前帧环形区已使用的大小
+uint32_t myFrameUniformOffset = 0; // 当前帧观察与投影矩阵的动态偏移
+vector<glm::mat4> myObjectTransforms{}; // 当前帧每个物体的模型矩阵
+uint64_t mySceneVersion = 0; // 绘制列表或推送常量的内容变化时递增
+
+VkFormat myTextureFormat = VK_FORMAT_R8G8B8A8_SRGB;
+uint32_t myTextureMipLevels = 1;
 VkImage myTextureImage;
 VkSampler myTextureSampler;
 VkImageView myTextureImageView;
-VkDeviceMemory myTextureImageMemory;
\ No newline at end of file
+MemoryAllocation myTextureImageMemory{};
\ No newline at end of file
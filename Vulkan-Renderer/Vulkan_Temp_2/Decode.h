@@ -0,0 +1,168 @@
+/// <summary>
+/// 
+///  解码线程池 | 完成队列 | 资源加载计时
+/// 
+/// </summary>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 解码完成的图像（RGBA8）
+struct DecodedImage
+{
+    uint32_t id = 0;
+    string filename;
+    stbi_uc* pixels = nullptr; // 解码失败时为空
+    int width = 0;
+    int height = 0;
+    double decodeMs = 0.0;
+};
+
+// 单个资源的加载耗时
+struct AssetTiming
+{
+    string name;
+    double decodeMs = 0.0; // 工作线程上的解码时间
+    double waitMs = 0.0; // 主线程等待解码完成的时间
+    double uploadMs = 0.0; // 主线程写入暂存区并录制拷贝的时间
+};
+
+mutex myDecodeMutex;
+condition_variable myDecodeRequested;
+condition_variable myDecodeFinished;
+
+deque<DecodedImage> myDecodeRequests{}; // 等待解码
+deque<DecodedImage> myDecodedImages{}; // 解码完成，按完成顺序排列
+uint32_t myDecodeRequestCount = 0;
+bool myDecodeStopping = false;
+
+WorkerThreads myDecodeWorkers{};
+
+vector<AssetTiming> myAssetTimings{};
+
+// ##############################################################
+
+double elapsedMs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+void decodeWorker()
+{
+    while (true)
+    {
+        DecodedImage image{};
+
+        // 等待新的解码请求
+        {
+            unique_lock<mutex> lock(myDecodeMutex);
+            myDecodeRequested.wait(lock, []() { return myDecodeStopping || !myDecodeRequests.empty(); });
+
+            if (myDecodeRequests.empty()) return;
+
+            image = move(myDecodeRequests.front());
+            myDecodeRequests.pop_front();
+        }
+
+        // 解码不持有锁，多个线程同时进行
+        auto start = chrono::high_resolution_clock::now();
+
+        int channels;
+        image.pixels = stbi_load(image.filename.c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
+        image.decodeMs = elapsedMs(start);
+
+        {
+            lock_guard<mutex> lock(myDecodeMutex);
+            myDecodedImages.push_back(move(image));
+        }
+        myDecodeFinished.notify_one();
+    }
+}
+
+uint32_t requestDecode(const string& filename)
+{
+    // 加入解码队列，立即返回
+    DecodedImage image{};
+    image.filename = filename;
+
+    {
+        lock_guard<mutex> lock(myDecodeMutex);
+        image.id = myDecodeRequestCount++;
+        myDecodeRequests.push_back(image);
+    }
+    myDecodeRequested.notify_one();
+
+    return image.id;
+}
+
+DecodedImage waitDecoded(double& waitMs)
+{
+    // 取出下一张解码完成的图像，先完成的先上传
+    auto start = chrono::high_resolution_clock::now();
+
+    unique_lock<mutex> lock(myDecodeMutex);
+    myDecodeFinished.wait(lock, []() { return !myDecodedImages.empty(); });
+
+    DecodedImage image = move(myDecodedImages.front());
+    myDecodedImages.pop_front();
+
+    waitMs = elapsedMs(start);
+
+    return image;
+}
+
+void printAssetTimings()
+{
+    // 输出 每个资源的解码与上传耗时
+    double decodeTotal = 0.0, waitTotal = 0.0, uploadTotal = 0.0;
+
+    for (const auto& timing : myAssetTimings)
+    {
+        cout << "Asset " << timing.name << ": decode " << timing.decodeMs << " ms, wait " << timing.waitMs << " ms, upload " << timing.uploadMs << " ms" << endl;
+
+        decodeTotal += timing.decodeMs;
+        waitTotal += timing.waitMs;
+        uploadTotal += timing.uploadMs;
+    }
+
+    cout << "Assets: " << myAssetTimings.size() << " on " << myDecodeWorkers.threads.size() << " decode threads, decode " << decodeTotal << " ms, wait " << waitTotal << " ms, upload " << uploadTotal << " ms" << endl;
+}
+
+// ##############################################################
+
+void stopDecodeWorkers()
+{
+    // 处理完剩余请求后退出
+    {
+        lock_guard<mutex> lock(myDecodeMutex);
+        myDecodeStopping = true;
+    }
+    myDecodeRequested.notify_all();
+}
+
+void createDecodeWorkers()
+{
+    // 保留一个核心给主线程录制上传命令
+    uint32_t workerCount = max(2u, thread::hardware_concurrency()) - 1;
+
+    myDecodeStopping = false;
+    myDecodeWorkers.stop = stopDecodeWorkers;
+    for (uint32_t i = 0; i < workerCount; i++) myDecodeWorkers.threads.emplace_back(decodeWorker);
+}
+
+void destroyDecodeWorkers()
+{
+    myDecodeWorkers.join();
+
+    // 释放 没有被取走的图像
+    for (auto& image : myDecodedImages) stbi_image_free(image.pixels);
+    myDecodedImages.clear();
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+/// <summary>
+/// 
+///  描述集分配器 | 更新模板 | 描述集缓存
+/// 
+/// </summary>
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 第一个描述池可分配的描述集数量，之后每个新池翻倍
+const uint32_t const_descriptorPoolSets = 64;
+const uint32_t const_descriptorPoolMaxSets = 4096;
+
+// 每个描述集平均使用的各类描述符数量
+const VkDescriptorPoolSize const_descriptorPoolRatios[] =
+{
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }
+};
+
+// 描述池用尽时自动追加新池，可整体重置
+struct DescriptorAllocator
+{
+    VkDescriptorPool currentPool = VK_NULL_HANDLE;
+    vector<VkDescriptorPool> usedPools{}; // 已经用尽的池
+    vector<VkDescriptorPool> freePools{}; // 重置后可以复用的池
+    uint32_t setsPerPool = const_descriptorPoolSets;
+};
+
+// 内容相同的描述集只分配和更新一次
+struct DescriptorCacheEntry
+{
+    VkDescriptorSetLayout layout;
+    vector<char> data; // 更新模板读取的数据
+    VkDescriptorSet set;
+};
+
+struct DescriptorCache
+{
+    DescriptorAllocator allocator{};
+    unordered_multimap<uint64_t, DescriptorCacheEntry> sets{};
+
+    uint32_t updateCount = 0; // 实际分配并更新的次数
+    uint32_t hitCount = 0; // 内容相同而跳过更新的次数
+};
+
+// 长期存在的描述集
+DescriptorCache myDescriptorCache{};
+
+// ##############################################################
+
+VkDescriptorPool createDescriptorPool(uint32_t maxSets)
+{
+    // 按比例设置 描述池大小
+    vector<VkDescriptorPoolSize> poolSizes{};
+    for (const auto& ratio : const_descriptorPoolRatios) poolSizes.push_back({ ratio.type, ratio.descriptorCount * maxSets });
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = maxSets;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(myDevice, &poolInfo, nullptr, &pool) != VK_SUCCESS) throw runtime_error("failed to create descriptor pool!");
+
+    return pool;
+}
+
+VkDescriptorPool grabDescriptorPool(DescriptorAllocator& allocator)
+{
+    // 优先复用重置过的池，否则创建更大的新池
+    if (!allocator.freePools.empty())
+    {
+        VkDescriptorPool pool = allocator.freePools.back();
+        allocator.freePools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = createDescriptorPool(allocator.setsPerPool);
+    allocator.setsPerPool = min(allocator.setsPerPool * 2, const_descriptorPoolMaxSets);
+
+    return pool;
+}
+
+VkDescriptorSet allocateDescriptorSet(DescriptorAllocator& allocator, VkDescriptorSetLayout layout)
+{
+    if (allocator.currentPool == VK_NULL_HANDLE) allocator.currentPool = grabDescriptorPool(allocator);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = allocator.currentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(myDevice, &allocInfo, &set);
+
+    // 当前池用尽时换一个池重试一次
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        allocator.usedPools.push_back(allocator.currentPool);
+        allocator.currentPool = grabDescriptorPool(allocator);
+
+        allocInfo.descriptorPool = allocator.currentPool;
+        result = vkAllocateDescriptorSets(myDevice, &allocInfo, &set);
+    }
+
+    if (result != VK_SUCCESS) throw runtime_error("failed to allocate descriptor sets!");
+
+    return set;
+}
+
+void resetDescriptorAllocator(DescriptorAllocator& allocator)
+{
+    // 一次释放所有描述集，池留作复用
+    if (allocator.currentPool != VK_NULL_HANDLE) allocator.usedPools.push_back(allocator.currentPool);
+    allocator.currentPool = VK_NULL_HANDLE;
+
+    for (VkDescriptorPool pool : allocator.usedPools)
+    {
+        vkResetDescriptorPool(myDevice, pool, 0);
+        allocator.freePools.push_back(pool);
+    }
+    allocator.usedPools.clear();
+}
+
+void destroyDescriptorAllocator(DescriptorAllocator& allocator)
+{
+    resetDescriptorAllocator(allocator);
+
+    for (VkDescriptorPool pool : allocator.freePools) vkDestroyDescriptorPool(myDevice, pool, nullptr);
+    allocator = DescriptorAllocator{};
+}
+
+VkDescriptorSet getDescriptorSet(DescriptorCache& cache, VkDescriptorSetLayout layout, VkDescriptorUpdateTemplate updateTemplate, const void* data, size_t size)
+{
+    // 数据需要完整初始化（包括填充字节），按字节比较
+    uint64_t hash = hashBytes(data, size, hashBytes(&layout, sizeof(layout)));
+
+    auto range = cache.sets.equal_range(hash);
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (entry->second.layout == layout && entry->second.data.size() == size && memcmp(entry->second.data.data(), data, size) == 0)
+        {
+            cache.hitCount++;
+            return entry->second.set;
+        }
+    }
+
+    // 分配 并通过模板一次写入所有绑定
+    VkDescriptorSet set = allocateDescriptorSet(cache.allocator, layout);
+    vkUpdateDescriptorSetWithTemplate(myDevice, set, updateTemplate, data);
+    cache.updateCount++;
+
+    const char* bytes = static_cast<const char*>(data);
+    cache.sets.emplace(hash, DescriptorCacheEntry{ layout, vector<char>(bytes, bytes + size), set });
+
+    return set;
+}
+
+void printDescriptorStatistics()
+{
+    // 输出 描述集缓存的命中情况与描述池数量
+    const DescriptorAllocator& allocator = myDescriptorCache.allocator;
+    size_t poolCount = allocator.usedPools.size() + allocator.freePools.size() + (allocator.currentPool != VK_NULL_HANDLE ? 1 : 0);
+
+    cout << "Descriptor sets: " << myDescriptorCache.updateCount << " updated, " << myDescriptorCache.hitCount << " cache hits, " << poolCount << " pools" << endl;
+}
+
+// ##############################################################
+
+void destroyDescriptorCache()
+{
+    destroyDescriptorAllocator(myDescriptorCache.allocator);
+    myDescriptorCache.sets.clear();
+}
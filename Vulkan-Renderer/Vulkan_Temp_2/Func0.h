@@ -1,6 +1,6 @@
 /// <summary>
 /// 
-///  ʵ | ֤ | 豸 | ߼豸
+///  实例 | 验证层 | 物理设备 | 逻辑设备
 /// 
 /// </summary>
 
@@ -11,7 +11,7 @@ using namespace std;
 
 // ##############################################################
 
-// Ƿ֤
+// 是否开启验证层
 #define DEBUG 
 
 #ifdef DEBUG
@@ -20,23 +20,24 @@ const bool enableValidationLayers = true;
 const bool enableValidationLayers = false;
 #endif
 
- // ʹ Vulkan SDK õ֤
+ // 使用 Vulkan SDK 内置的验证层
 const vector<const char*> validationLayers =
 {
     "VK_LAYER_KHRONOS_validation"
 };
 
-// ʹ Vulkan SDK õ豸չ
+// 使用 Vulkan SDK 内置的设备拓展
 const vector<const char*> deviceExtensions =
 {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-// ж  Ƿ֧ ͼζ  ʾ
+// 用于判断 队列组 是否支持 图形队列 和 演示队列
 struct QueueFamilyIndices
 {
     optional<uint32_t> graphicsFamily;
     optional<uint32_t> presentFamily;
+    optional<uint32_t> transferFamily; // 专用传输队列组，没有时退化为图形队列组
 
     bool isComplete()
     {
@@ -48,13 +49,13 @@ struct QueueFamilyIndices
 
 vector<const char*> getRequiredExtensions()
 {
-    // ȡ GLFW  VK չ
+    // 获取 GLFW 所需 VK 拓展
     uint32_t glfwExtensionCount = 0;
     const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
     vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
-    // ֤㣬 Իص չ
+    // 如果开启了验证层，添加 调试回调 拓展
     if (enableValidationLayers) extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
     return extensions;
@@ -62,7 +63,7 @@ vector<const char*> getRequiredExtensions()
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData)
 {
-    // Ϊ ʵʻص¼ʱ
+    // 作为 实际回调函数，发生调试事件时调用
     cerr << "validation layer: " << pCallbackData->pMessage << endl;
 
     return VK_FALSE;
@@ -70,32 +71,32 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityF
 
 void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
 {
-    // ʼ
+    // 初始化
     createInfo = {};
 
-    // ṹ
+    // 结构体类型
     createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
 
-    // ؼVERBOSEWARNING  ERROR
+    // 严重级别：VERBOSE、WARNING 和 ERROR
     createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
 
-    // ϢͣGENERALVALIDATION  PERFORMANCE
+    // 信息类型：GENERAL、VALIDATION 和 PERFORMANCE
     createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
 
-    // Ļص
+    // 具体的回调函数名称
     createInfo.pfnUserCallback = debugCallback;
 }
 
 bool checkValidationLayerSupport()
 {
-    // ȡ֤Ϣ
+    // 获取验证层信息
     uint32_t layerCount;
     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
 
     vector<VkLayerProperties> availableLayers(layerCount);
     vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
 
-    // ж ǰ֤ Ƿ ֤ 
+    // 判断 当前验证层 是否存在于 内置验证层 中
     for (const char* layerName : validationLayers)
     {
         bool layerFound = false;
@@ -119,36 +120,50 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
 {
     QueueFamilyIndices indices;
 
-    // ȡֵ֧Ķ
+    // 获取支持的队列组的数量
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
 
-    // ȡֵ֧Ķб
+    // 获取支持的队列组的列表
     vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
     int i = 0;
     for (const auto& queueFamily : queueFamilies)
     {
-        // ֧ͼĶ
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.graphicsFamily = i;
+        // 标记支持图形命令的队列
+        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            if (!indices.graphicsFamily.has_value()) indices.graphicsFamily = i;
+        }
+        else if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)
+        {
+            // 没有纯传输队列时，不支持图形命令的计算队列也可以承担传输
+            if (!indices.transferFamily.has_value()) indices.transferFamily = i;
+        }
+        else if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+        {
+            // 标记只支持传输命令的队列，通常对应独立的 DMA 引擎
+            if (!indices.transferFamily.has_value() || (queueFamilies[indices.transferFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT)) indices.transferFamily = i;
+        }
 
-        // ֧ʾĶ
+        // 标记支持演示命令的队列，优先与图形队列相同
         VkBool32 presentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, mySurface, &presentSupport);
-        if (presentSupport) indices.presentFamily = i;
-
-        if (indices.isComplete()) break;
+        if (presentSupport && (!indices.presentFamily.has_value() || indices.graphicsFamily == static_cast<uint32_t>(i))) indices.presentFamily = i;
 
         i++;
     }
 
+    // 没有专用队列组时，传输交给图形队列
+    if (indices.graphicsFamily.has_value() && !indices.transferFamily.has_value()) indices.transferFamily = indices.graphicsFamily;
+
     return indices;
 }
 
 bool checkDeviceExtensionSupport(VkPhysicalDevice device)
 {
-    // ȡ 豸ֵ֧չ
+    // 获取 物理设备支持的拓展
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
@@ -162,48 +177,119 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device)
         requiredExtensions.erase(extension.extensionName);
     }
 
-    // ж豸ֵ֧չǷе صչ
+    // 判断物理设备支持的拓展是否包含所有的 交换链相关的拓展
     return requiredExtensions.empty();
 }
 
+bool checkCoreOrExtension(VkPhysicalDevice device, uint32_t coreVersion, const char* extensionName)
+{
+    // 功能在 coreVersion 中是核心功能，更低版本的设备需要支持对应拓展
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    if (min(properties.apiVersion, const_maxApiVersion) >= coreVersion) return true;
+
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) if (strcmp(extension.extensionName, extensionName) == 0) return true;
+
+    return false;
+}
+
+bool checkDynamicRenderingSupport(VkPhysicalDevice device)
+{
+    // 动态渲染在 1.3 中是核心功能，1.2 的设备可以通过拓展使用
+    if (!checkCoreOrExtension(device, VK_API_VERSION_1_3, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) return false;
+
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
+bool checkSynchronization2Support(VkPhysicalDevice device)
+{
+    // 同步2 同样在 1.3 中成为核心功能
+    if (!checkCoreOrExtension(device, VK_API_VERSION_1_3, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) return false;
+
+    VkPhysicalDeviceSynchronization2Features synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &synchronization2Features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    return synchronization2Features.synchronization2 == VK_TRUE;
+}
+
 bool isDeviceSuitable(VkPhysicalDevice device)
 {
-    // ֧
+    // 检查队列支持
     QueueFamilyIndices indices = findQueueFamilies(device);
 
-    // չ֧
+    // 检查拓展支持
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    return indices.isComplete() && extensionsSupported;
+    // 检查 API 版本，描述符更新模板需要 Vulkan 1.1，时间线信号量需要 1.2
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    bool versionSupported = properties.apiVersion >= const_apiVersion;
+
+    // 检查 时间线信号量，帧节奏与上传批次都依赖它
+    bool timelineSupported = false;
+    if (versionSupported)
+    {
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &timelineFeatures;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        timelineSupported = timelineFeatures.timelineSemaphore == VK_TRUE;
+    }
+
+    return indices.isComplete() && extensionsSupported && versionSupported && timelineSupported;
 }
 
 // ##############################################################
 
 void createVulkanInstance()
 {
-    // ж֤Ƿ
+    // 判断验证层是否可用
     if (enableValidationLayers && !checkValidationLayerSupport()) throw runtime_error("validation layers not available");
 
-    //  ӦóϢ
+    // 填充 应用程序信息
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "Hello Triangle";
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = const_maxApiVersion;
 
-    //  VulkanʵϢ
+    // 填充 Vulkan实例信息
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
 
-    //  VulkanչϢ
+    // 填充 Vulkan拓展信息
     auto extensions = getRequiredExtensions();
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
-    //  ֤Ϣ
+    // 填充 验证层信息
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
     if (enableValidationLayers)
     {
@@ -219,30 +305,30 @@ void createVulkanInstance()
         createInfo.pNext = nullptr;
     }
 
-    // ʹ VkInstanceCreateInfo  VK ʵ
+    // 使用 VkInstanceCreateInfo 创建 VK 实例
     if (vkCreateInstance(&createInfo, nullptr, &myVulkanInstance) != VK_SUCCESS) throw runtime_error("failed to create instance!");
 }
 
 void pickPhysicalDevice()
 {
-    // ȡ֧ VK  GPU 
+    // 获取支持 VK 的 GPU 数量
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(myVulkanInstance, &deviceCount, nullptr);
 
     if (deviceCount == 0) throw runtime_error("No GPUs with Vulkan support");
 
-    // ȡ֧ VK  GPU б
+    // 获取支持 VK 的 GPU 列表
     vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(myVulkanInstance, &deviceCount, devices.data());
 
-    //  GPU бһʵΪǰ GPU
+    // 遍历 GPU 列表，将第一个合适的作为当前 GPU
     for (const auto& device : devices)
     {
         if (isDeviceSuitable(device))
         {
             myPhysicalDevice = device;
 
-            //  GPU 
+            // 输出 GPU 的名称
             VkPhysicalDeviceProperties deviceProperties;
             vkGetPhysicalDeviceProperties(myPhysicalDevice, &deviceProperties);
             cout << "Selected GPU: " << deviceProperties.deviceName << endl;
@@ -258,9 +344,9 @@ void createLogicalDevice()
 {
     QueueFamilyIndices indices = findQueueFamilies(myPhysicalDevice);
 
-    //  дϢ
+    // 填充 队列创建信息
     vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
-    set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -272,13 +358,74 @@ void createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    //  豸ܼ
+    // 填充 设备功能集成
     VkPhysicalDeviceFeatures deviceFeatures{};
 
-    //  Բ
+    // 开启 各项异性采样器
     deviceFeatures.samplerAnisotropy = VK_TRUE;
 
-    //  ߼豸Ϣ
+    // 开启 设备支持的纹理压缩格式
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(myPhysicalDevice, &supportedFeatures);
+
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    deviceFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+    deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+
+    // 记录 实际可用的 API 版本
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(myPhysicalDevice, &properties);
+    myDeviceApiVersion = min(properties.apiVersion, const_maxApiVersion);
+
+    vector<const char*> extensions = deviceExtensions;
+
+    // 开启 动态渲染
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+    myDynamicRenderingEnabled = const_enableDynamicRendering && checkDynamicRenderingSupport(myPhysicalDevice);
+    if (myDynamicRenderingEnabled)
+    {
+        dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+        if (myDeviceApiVersion < VK_API_VERSION_1_3) extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+
+    cout << "Dynamic rendering: " << (myDynamicRenderingEnabled ? "enabled" : "disabled, using render pass") << endl;
+
+    // 开启 同步2
+    VkPhysicalDeviceSynchronization2Features synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+
+    mySynchronization2Enabled = const_enableSynchronization2 && checkSynchronization2Support(myPhysicalDevice);
+    if (mySynchronization2Enabled)
+    {
+        synchronization2Features.synchronization2 = VK_TRUE;
+
+        if (myDeviceApiVersion < VK_API_VERSION_1_3) extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+
+    cout << "Synchronization2: " << (mySynchronization2Enabled ? "enabled" : "disabled, using vkCmdPipelineBarrier") << endl;
+
+    // 开启 时间线信号量
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+
+    // 功能结构体串成 pNext 链
+    void* featureChain = &timelineFeatures;
+    if (myDynamicRenderingEnabled)
+    {
+        dynamicRenderingFeatures.pNext = featureChain;
+        featureChain = &dynamicRenderingFeatures;
+    }
+    if (mySynchronization2Enabled)
+    {
+        synchronization2Features.pNext = featureChain;
+        featureChain = &synchronization2Features;
+    }
+
+    // 填充 逻辑设备信息
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -286,11 +433,12 @@ void createLogicalDevice()
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
     createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.pNext = featureChain;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
-    //  ֤Ϣ
+    // 填充 验证层信息
     if (enableValidationLayers)
     {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -298,12 +446,40 @@ void createLogicalDevice()
     }
     else createInfo.enabledLayerCount = 0;
 
-    // ʹ VkDeviceCreateInfo ߼豸
+    // 使用 VkDeviceCreateInfo 创建逻辑设备
     if (vkCreateDevice(myPhysicalDevice, &createInfo, nullptr, &myDevice) != VK_SUCCESS) throw runtime_error("failed to create logical device!");
 
-    // ָͼζеľ
+    // 保存指向图形队列的句柄
     vkGetDeviceQueue(myDevice, indices.graphicsFamily.value(), 0, &myGraphicsQueue);
 
-    // ָʾеľ
+    // 获取 动态渲染的命令函数
+    if (myDynamicRenderingEnabled)
+    {
+        bool core = myDeviceApiVersion >= VK_API_VERSION_1_3;
+        myCmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(myDevice, core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR");
+        myCmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(myDevice, core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR");
+
+        if (myCmdBeginRendering == nullptr || myCmdEndRendering == nullptr) throw runtime_error("failed to load dynamic rendering commands!");
+    }
+
+    // 获取 同步2 的屏障命令函数
+    if (mySynchronization2Enabled)
+    {
+        bool core = myDeviceApiVersion >= VK_API_VERSION_1_3;
+        myCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(myDevice, core ? "vkCmdPipelineBarrier2" : "vkCmdPipelineBarrier2KHR");
+
+        if (myCmdPipelineBarrier2 == nullptr) throw runtime_error("failed to load synchronization2 commands!");
+    }
+
+    // 保存指向演示队列的句柄
     vkGetDeviceQueue(myDevice, indices.presentFamily.value(), 0, &myPresentQueue);
+
+    // 保存指向传输队列的句柄
+    vkGetDeviceQueue(myDevice, indices.transferFamily.value(), 0, &myTransferQueue);
+
+    // 记录队列组，供所有权转移使用
+    myGraphicsQueueFamily = indices.graphicsFamily.value();
+    myTransferQueueFamily = indices.transferFamily.value();
+
+    if (myTransferQueueFamily != myGraphicsQueueFamily) cout << "Dedicated transfer queue family: " << myTransferQueueFamily << endl;
 }
\ No newline at end of file
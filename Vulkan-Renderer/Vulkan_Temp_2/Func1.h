@@ -1,6 +1,6 @@
 /// <summary>
 /// 
-///   |  | ͼͼ
+///  表面对象 | 交换链 | 图像视图
 /// 
 /// </summary>
 
@@ -10,12 +10,12 @@ using namespace std;
 
 // ##############################################################
 
-// Ϣ
+// 交换链信息
 struct SwapChainSupportDetails
 {
-    VkSurfaceCapabilitiesKHR capabilities{}; // ͼ߷Χ
-    vector<VkSurfaceFormatKHR> formats{}; // ɫռ䡢ظʽ
-    vector<VkPresentModeKHR> presentModes{}; // ʾģʽ
+    VkSurfaceCapabilitiesKHR capabilities{}; // 图像数量、宽高范围
+    vector<VkSurfaceFormatKHR> formats{}; // 颜色空间、像素格式
+    vector<VkPresentModeKHR> presentModes{}; // 可用演示模式
 };
 
 // ##############################################################
@@ -73,10 +73,10 @@ SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device)
 {
     SwapChainSupportDetails details;
 
-    // ȡ豸ָ ͼʾ Ļ
+    // 获取物理设备上指定 图像显示对象 的基本功能
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, mySurface, &details.capabilities);
 
-    // ȡ豸ָ ͼʾ Ļʽ
+    // 获取物理设备上指定 图像显示对象 的基本格式
     uint32_t formatCount;
     vkGetPhysicalDeviceSurfaceFormatsKHR(device, mySurface, &formatCount, nullptr);
 
@@ -86,7 +86,7 @@ SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device)
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, mySurface, &formatCount, details.formats.data());
     }
 
-    // ȡ豸ָ ͼʾ Ŀʾ
+    // 获取物理设备上指定 图像显示对象 的可用演示
     uint32_t presentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(device, mySurface, &presentModeCount, nullptr);
 
@@ -101,25 +101,25 @@ SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device)
 
 void cleanupSwapChain()
 {
-    //  ֡
+    // 销毁 帧缓冲区
     for (auto framebuffer : mySwapChainFramebuffers)
     {
         vkDestroyFramebuffer(myDevice, framebuffer, nullptr);
     }
 
-    //  ͼͼ
+    // 销毁 图像视图
     for (auto imageView : mySwapChainImageViews)
     {
         vkDestroyImageView(myDevice, imageView, nullptr);
     }
 
-    //  
+    // 销毁 交换链条
     vkDestroySwapchainKHR(myDevice, mySwapChain, nullptr);
 }
 
-VkImageView createImageView(VkImage image, VkFormat format)
+VkImageView createImageView(VkImage image, VkFormat format, uint32_t mipLevels)
 {
-    //  ͼͼϢ
+    // 设置 图像视图的信息
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
@@ -127,11 +127,11 @@ VkImageView createImageView(VkImage image, VkFormat format)
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    //  ͼͼ
+    // 创建 图像视图
     VkImageView imageView;
     if (vkCreateImageView(myDevice, &viewInfo, nullptr, &imageView) != VK_SUCCESS) throw runtime_error("failed to create texture image view!");
 
@@ -142,7 +142,7 @@ VkImageView createImageView(VkImage image, VkFormat format)
 
 void createSurface()
 {
-    //  
+    // 创建 表面对象
     if (glfwCreateWindowSurface(myVulkanInstance, myWindow, nullptr, &mySurface) != VK_SUCCESS)
     {
         throw runtime_error("failed to create window surface!");
@@ -151,26 +151,26 @@ void createSurface()
 
 void createSwapChain()
 {
-    // ȡǰ豸ڵǰֵ֧
+    // 获取当前设备在当前环境下支持的属性
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(myPhysicalDevice);
 
-    // ȡָ ʽ
+    // 获取指定 基本格式
     VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
 
-    // ȡָ ʾģʽ
+    // 获取指定 演示模式
     VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 
-    // ȡָ ͼƬ
+    // 获取指定 图片宽高
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    //  ֵ֧СͼƬ
+    // 计算 交换链支持的最小图片数
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
     if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
     {
         imageCount = swapChainSupport.capabilities.maxImageCount;
     }
 
-    //  Ϣ
+    // 填充 交换链创建信息
     VkSwapchainCreateInfoKHR createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     createInfo.surface = mySurface;
@@ -182,7 +182,7 @@ void createSwapChain()
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    // жǷͬʱ֧ ͼζ  ʾ
+    // 判断是否同时支持 图形队列 和 演示队列
     QueueFamilyIndices indices = findQueueFamilies(myPhysicalDevice);
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
@@ -201,21 +201,21 @@ void createSwapChain()
 
     createInfo.oldSwapchain = VK_NULL_HANDLE;
 
-    // ʹ "Ϣ"  ""
+    // 使用 "交换链创建信息" 创建 "交换链对象"
     if (vkCreateSwapchainKHR(myDevice, &createInfo, nullptr, &mySwapChain) != VK_SUCCESS)
     {
         throw runtime_error("failed to create swap chain!");
     }
 
-    // ȡǰ 뽻صĿɳͼ
+    // 获取当前 与交换链相关的可呈现图像数组
     vkGetSwapchainImagesKHR(myDevice, mySwapChain, &imageCount, nullptr);
     mySwapChainImages.resize(imageCount);
     vkGetSwapchainImagesKHR(myDevice, mySwapChain, &imageCount, mySwapChainImages.data());
 
-    // ȡ ɳͼӦĸʽ
+    // 获取 可呈现图像数组对应的格式
     mySwapChainImageFormat = surfaceFormat.format;
 
-    // ȡ ɳͼӦĿ
+    // 获取 可呈现图像数组对应的宽高
     mySwapChainExtent = extent;
 }
 
@@ -225,6 +225,6 @@ void createImageViews()
 
     for (uint32_t i = 0; i < mySwapChainImages.size(); i++) 
     {
-        mySwapChainImageViews[i] = createImageView(mySwapChainImages[i], mySwapChainImageFormat);
+        mySwapChainImageViews[i] = createImageView(mySwapChainImages[i], mySwapChainImageFormat, 1);
     }
 }
\ No newline at end of file
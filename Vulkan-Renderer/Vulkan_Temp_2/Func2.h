@@ -1,59 +1,57 @@
 /// <summary>
 /// 
-///  Ⱦͨ | Ⱦ |  | 㻺
+///  渲染通道 | 渲染管线 | 命令缓冲 | 顶点缓冲
 /// 
 /// </summary>
 #include <ctime>
 #include <array>
 #include <vector>
-#include <fstream>
 using namespace std;
 
 // ##############################################################
 
-// Ϣʽ
+// 顶点信息格式
 
-struct Vertex 
+// 加载时使用的浮点顶点，网格文件也可以按此格式存储
+struct SourceVertex
 {
     glm::vec2 pos;
     glm::vec3 color;
     glm::vec2 texCoord;
+};
 
-    static VkVertexInputBindingDescription getBindingDescription() 
-    {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        return bindingDescription;
-    }
-
-    static array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() 
-    {
-        array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
+// 上传到顶点缓冲区的压缩顶点：半精度位置、16 位纹理坐标、8 位颜色，共 12 字节
+// 位置与纹理坐标相邻，量化时一次写入
+struct Vertex 
+{
+    Half2 pos;
+    Unorm16x2 texCoord;
+    Unorm8x4 color;
+};
 
-        attributeDescriptions[2].binding = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+// 属性顺序即着色器中的 location
+template<> struct VertexLayout<SourceVertex>
+{
+    static constexpr array<VertexAttribute, 3> attributes = { {
+        VERTEX_ATTRIBUTE(SourceVertex, pos),
+        VERTEX_ATTRIBUTE(SourceVertex, color),
+        VERTEX_ATTRIBUTE(SourceVertex, texCoord)
+    } };
+};
 
-        return attributeDescriptions;
-    }
+template<> struct VertexLayout<Vertex>
+{
+    static constexpr array<VertexAttribute, 3> attributes = { {
+        VERTEX_ATTRIBUTE(Vertex, pos),
+        VERTEX_ATTRIBUTE(Vertex, color),
+        VERTEX_ATTRIBUTE(Vertex, texCoord)
+    } };
 };
 
-// Ӳ붥Ϣ
-vector<Vertex> vertices = 
+static_assert(sizeof(Vertex) == 12, "unexpected padding in packed vertex!");
+
+// 硬编码顶点信息
+vector<SourceVertex> vertices = 
 {
     {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
     {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
@@ -61,7 +59,7 @@ vector<Vertex> vertices =
     {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}
 };
 
-// ӲϢ
+// 硬编码索引信息
 vector<uint16_t> indices = 
 {
     0, 1, 2, 2, 3, 0
@@ -69,171 +67,216 @@ vector<uint16_t> indices =
 
 // ##############################################################
 
-VkShaderModule createShaderModule(const vector<char>& code)
+void beginRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool secondary)
 {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
 
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(myDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    if (myDynamicRenderingEnabled)
     {
-        throw runtime_error("failed to create shader module!");
+        // 直接渲染到交换链图像视图，布局转换由渲染图完成
+        VkRenderingAttachmentInfo colorAttachment{};
+        colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorAttachment.imageView = mySwapChainImageViews[imageIndex];
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue = clearColor;
+
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea.offset = { 0, 0 };
+        renderingInfo.renderArea.extent = mySwapChainExtent;
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+
+        myCmdBeginRendering(commandBuffer, &renderingInfo);
+        return;
     }
 
-    return shaderModule;
-}
-
-static vector<char> readFile(const string& filename)
-{
-    ifstream file(filename, ios::ate | ios::binary);
-
-    if (!file.is_open()) throw runtime_error("failed to open file!");
-
-    size_t fileSize = (size_t)file.tellg();
-    vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
+    // 初始化 渲染通道
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = myRenderPass;
+    renderPassInfo.framebuffer = mySwapChainFramebuffers[imageIndex];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = mySwapChainExtent;
 
-    file.close();
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearColor;
 
-    return buffer;
+    // 标记 渲染通道起点
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 }
 
-uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+void endRendering(VkCommandBuffer commandBuffer)
 {
-    // ȡָ͵ڴ
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(myPhysicalDevice, &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    if (myDynamicRenderingEnabled)
     {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) return i;
+        myCmdEndRendering(commandBuffer);
+        return;
     }
 
-    throw runtime_error("failed to find suitable memory type!");
+    // 标记 渲染通道终点
+    vkCmdEndRenderPass(commandBuffer);
 }
 
-void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool reusable)
 {
-    //  
+    // 标记 命令缓冲区起点，缓存的命令缓冲区会被多次提交
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = reusable ? 0 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
     {
         throw runtime_error("failed to begin recording command buffer!");
     }
 
-    // ʼ Ⱦͨ
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = myRenderPass;
-    renderPassInfo.framebuffer = mySwapChainFramebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = mySwapChainExtent;
+    // 展开 这一帧的绘制列表
+    buildDrawList();
 
-    VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
+    // 次级命令缓冲区所在的命令池每帧重置，缓存的命令缓冲区不能引用它们
+    uint32_t threadCount = reusable ? 0 : getRecordThreadCount();
 
-    //  Ⱦͨ
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // 构建 这一帧的渲染图，交换链图像获取时内容不保留，结束时用于演示
+    RenderGraph& graph = myRenderGraph;
+    resetRenderGraph(graph);
 
-    //  Ⱦ
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myGraphicsPipeline);
+    uint32_t backBuffer = importImage(graph, "backbuffer", mySwapChainImages[imageIndex], VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, RESOURCE_USAGE_ACQUIRE);
+    exportResource(graph, backBuffer, RESOURCE_USAGE_PRESENT);
 
-    //  Ⱦӿ
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)mySwapChainExtent.width;
-    viewport.height = (float)mySwapChainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-    //  ü
-    VkRect2D scissor{};
-    scissor.offset = { 0, 0 };
-    scissor.extent = mySwapChainExtent;
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    uint32_t mainPass = addPass(graph, "main", [imageIndex, threadCount](VkCommandBuffer commandBuffer)
+    {
+        if (threadCount == 0)
+        {
+            // 绘制较少时直接录制
+            beginRendering(commandBuffer, imageIndex, false);
+            recordDraws(commandBuffer, currentFrame, 0, myDrawList.size());
+        }
+        else
+        {
+            // 多个线程同时录制次级命令缓冲区，渲染开始前完成即可
+            recordSecondaryCommandBuffers(currentFrame, imageIndex, threadCount);
+
+            beginRendering(commandBuffer, imageIndex, true);
+            vkCmdExecuteCommands(commandBuffer, threadCount, mySecondaryCommandBuffers[currentFrame].data());
+        }
+
+        // 结束 渲染
+        endRendering(commandBuffer);
+    });
+    useImage(graph, mainPass, backBuffer, RESOURCE_USAGE_COLOR_ATTACHMENT);
+
+    // 编译 渲染图：剔除无用的通道，生成合并的屏障，然后按顺序录制
+    compileRenderGraph(graph);
+    executeRenderGraph(graph, commandBuffer);
+
+    // 标记 命令缓冲区终点
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw runtime_error("failed to record command buffer!");
+}
 
-    //  㻺
-    VkBuffer vertexBuffers[] = { myVertexBuffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+VkCommandBuffer recordTransientCommandBuffer(uint32_t frame, uint32_t imageIndex)
+{
+    // 重置这一帧的所有命令池，绘制较多时多线程录制次级命令缓冲区
+    resetFrameCommandPools(frame);
+    recordCommandBuffer(myCommandBuffers[frame], imageIndex, false);
+    return myCommandBuffers[frame];
+}
 
-    //  
-    vkCmdBindIndexBuffer(commandBuffer, myIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+VkCommandBuffer getFrameCommandBuffer(uint32_t frame, uint32_t imageIndex)
+{
+    // 不复用时每帧重新录制
+    if (!const_enableCommandBufferReuse) return recordTransientCommandBuffer(frame, imageIndex);
 
-    //  
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myPipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+    // 统计 场景版本连续不变的帧数
+    if (mySceneVersion == myObservedSceneVersion) myStableSceneFrames++;
+    else
+    {
+        myObservedSceneVersion = mySceneVersion;
+        myStableSceneFrames = 0;
+    }
 
-    // 
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    // 这一帧的时间线已经等待过，同一帧槽位的命令缓冲区不在使用中
+    CachedCommandBuffer& cached = myCachedCommandBuffers[frame][imageIndex];
 
-    //  Ⱦͨյ
-    vkCmdEndRenderPass(commandBuffer);
+    // 录制时的状态都没有变化，直接提交上一次的命令
+    if (cached.recorded && cached.sceneVersion == mySceneVersion && cached.pipeline == myGraphicsPipeline && cached.uniformOffset == myFrameUniformOffset)
+    {
+        myCommandBufferReuseCount++;
+        return cached.commandBuffer;
+    }
 
-    //  յ
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw runtime_error("failed to record command buffer!");
-}
+    // 场景仍在变化时缓存很快失效，按每帧的方式录制，不失去多线程录制
+    if (myStableSceneFrames == 0)
+    {
+        myCommandBufferTransientCount++;
+        return recordTransientCommandBuffer(frame, imageIndex);
+    }
 
-VkCommandBuffer beginSingleTimeCommands()
-{
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = myCommandPool;
-    allocInfo.commandBufferCount = 1;
+    if (cached.commandBuffer == VK_NULL_HANDLE)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = myCachedCommandPools[frame];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
 
-    // 
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(myDevice, &allocInfo, &commandBuffer);
+        if (vkAllocateCommandBuffers(myDevice, &allocInfo, &cached.commandBuffer) != VK_SUCCESS) throw runtime_error("failed to allocate cached command buffer!");
+    }
 
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    // 场景稳定后录制一次缓存的命令缓冲区，开始录制时被隐式重置
+    recordCommandBuffer(cached.commandBuffer, imageIndex, true);
 
-    //  
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    cached.recorded = true;
+    cached.sceneVersion = mySceneVersion;
+    cached.pipeline = myGraphicsPipeline;
+    cached.uniformOffset = myFrameUniformOffset;
+    myCommandBufferRecordCount++;
 
-    return commandBuffer;
+    return cached.commandBuffer;
 }
 
-void endSingleTimeCommands(VkCommandBuffer commandBuffer)
+void uploadBuffer(VkBuffer dstBuffer, const MemoryAllocation& dstMemory, const void* data, VkDeviceSize size)
 {
-    //  յ
-    vkEndCommandBuffer(commandBuffer);
+    // 目标内存 CPU 可见时直接写入，跳过暂存拷贝
+    if (dstMemory.mapped != nullptr)
+    {
+        memcpy(dstMemory.mapped, data, (size_t)size);
+        return;
+    }
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    // 按暂存环形缓冲区的大小分块上传
+    VkDeviceSize uploaded = 0;
+    while (uploaded < size)
+    {
+        VkDeviceSize chunkSize = min(size - uploaded, const_stagingBufferSize);
 
-    vkQueueSubmit(myGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(myGraphicsQueue);
+        // 从暂存环形缓冲区中分配空间并写入数据
+        VkDeviceSize stagingOffset = allocateStaging(chunkSize, 4);
 
-    vkFreeCommandBuffers(myDevice, myCommandPool, 1, &commandBuffer);
-}
+        memcpy(static_cast<char*>(myStagingBufferMemory.mapped) + stagingOffset, static_cast<const char*>(data) + uploaded, (size_t)chunkSize);
 
-void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        // 拷贝命令录制到当前上传批次，空间不足时分配过程可能已提交之前的批次
+        VkCommandBuffer commandBuffer = getUploadCommandBuffer();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = uploaded;
+        copyRegion.size = chunkSize;
+        vkCmdCopyBuffer(commandBuffer, myStagingBuffer, dstBuffer, 1, &copyRegion);
 
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        uploaded += chunkSize;
+    }
 
-    endSingleTimeCommands(commandBuffer);
+    // 之后由图形队列读取，需要时转移所有权
+    releaseBuffer(dstBuffer);
 }
 
-void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) 
+void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MemoryUsage memoryUsage, VkBuffer& buffer, MemoryAllocation& bufferMemory) 
 {
-    // ָСĶ㻺
+    // 创建指定大小的顶点缓冲区
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
@@ -242,27 +285,22 @@ void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyF
 
     if (vkCreateBuffer(myDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) throw runtime_error("failed to create buffer!");
 
-    // ȡҪĻڴϢ
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(myDevice, buffer, &memRequirements);
-
-    // Ϊָ͵ڴ
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    // 获取需要的缓冲区内存信息
+    bool prefersDedicated = false;
+    VkMemoryRequirements memRequirements = getBufferMemoryRequirements(buffer, prefersDedicated);
 
-    if (vkAllocateMemory(myDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) throw runtime_error("failed to allocate buffer memory!");
+    // 从内存块中为缓冲区子分配指定用途的内存，驱动希望独占时使用独立分配
+    bufferMemory = allocateMemory(memRequirements, memoryUsage, true, prefersDedicated, VK_NULL_HANDLE, buffer);
 
-    // ڴ浽ָ
-    vkBindBufferMemory(myDevice, buffer, bufferMemory, 0);
+    // 绑定内存到指定缓冲区
+    vkBindBufferMemory(myDevice, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
 // ##############################################################
 
 void createRenderPass()
 {
-    //  ɫ
+    // 设置 颜色缓冲区描述
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = mySwapChainImageFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -270,21 +308,22 @@ void createRenderPass()
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // 渲染图负责通道之间的布局转换，渲染通道内保持附件布局不变
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-    //  ɫ
+    // 设置 颜色缓冲区引用
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-    //  ͨϢ
+    // 设置 子通道创建信息
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
 
-    //  ȾͨϢ
+    // 填充 渲染通道创建信息
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = 1;
@@ -300,199 +339,209 @@ void createRenderPass()
 
 void createGraphicsPipeline()
 {
-    //  ɫģ
-    auto vertShaderCode = readFile("vert.spv");
-    auto fragShaderCode = readFile("frag.spv");
-
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
-
-    //  ɫ׶
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-    //  
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    //  ͼԪ
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    //  ӿ״̬
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
-
-    //  դ
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    //  ز
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-    //  Ϸʽ
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-
-    //  ϲ
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f;
-    colorBlending.blendConstants[1] = 0.0f;
-    colorBlending.blendConstants[2] = 0.0f;
-    colorBlending.blendConstants[3] = 0.0f;
-
-    //  ̬״̬
-    vector<VkDynamicState> dynamicStates =
-    {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates = dynamicStates.data();
-
-    //  ߲
+    // 设置 推送常量范围
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = const_pushConstantStages;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    // 设置 管线布局
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = 1;
     pipelineLayoutInfo.pSetLayouts = &myDescriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
     if (vkCreatePipelineLayout(myDevice, &pipelineLayoutInfo, nullptr, &myPipelineLayout) != VK_SUCCESS)
     {
         throw runtime_error("failed to create pipeline layout!");
     }
 
-    //  Ⱦ
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = myPipelineLayout;
-    pipelineInfo.renderPass = myRenderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-    if (vkCreateGraphicsPipelines(myDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &myGraphicsPipeline) != VK_SUCCESS)
+    // 设置 管线描述
+    PipelineDescription description{};
+    description.vertexShader = const_vertShader;
+    description.fragmentShader = const_fragShader;
+
+    // 着色器变体：纹理坐标放大 2 倍并采样纹理，不乘以顶点颜色
+    setShaderConstant(description, SHADER_CONSTANT_UV_SCALE, 2.0f);
+    setShaderConstant(description, SHADER_CONSTANT_USE_TEXTURE, true);
+    setShaderConstant(description, SHADER_CONSTANT_USE_VERTEX_COLOR, false);
+    setShaderConstant(description, SHADER_CONSTANT_USE_MODEL_MATRIX, true);
+
+    auto attributeDescriptions = getVertexAttributeDescriptions<Vertex>();
+    description.vertexBinding = getVertexBindingDescription<Vertex>();
+    description.vertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+
+    description.colorFormat = mySwapChainImageFormat;
+    description.layout = myPipelineLayout;
+    description.renderPass = myRenderPass; // 动态渲染时为空
+
+    // 材质可能用到的混合与剔除组合全部加入队列，绘制时只查表不编译
+    for (BlendMode blendMode : { BLEND_MODE_OPAQUE, BLEND_MODE_ALPHA, BLEND_MODE_ADDITIVE })
     {
-        throw runtime_error("failed to create graphics pipeline!");
+        for (VkCullModeFlags cullMode : { VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_NONE })
+        {
+            PipelineDescription variant = description;
+            variant.blendMode = blendMode;
+            variant.cullMode = cullMode;
+            queuePipeline(variant);
+        }
     }
 
-    //  ɫģ
-    vkDestroyShaderModule(myDevice, fragShaderModule, nullptr);
-    vkDestroyShaderModule(myDevice, vertShaderModule, nullptr);
+    // 并行编译 所有排队的管线
+    compileQueuedPipelines();
+
+    myGraphicsPipeline = getPipeline(description);
 }
 
 void createCommandBuffer()
 {
     myCommandBuffers.resize(const_maxFrames);
 
-    // Ϊطһ
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = myCommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)myCommandBuffers.size();
+    // 每帧的命令池分配一个主命令缓冲区
+    for (uint32_t frame = 0; frame < const_maxFrames; frame++)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = myCommandPools[frame];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(myDevice, &allocInfo, &myCommandBuffers[frame]) != VK_SUCCESS)
+        {
+            throw runtime_error("failed to allocate command buffers!");
+        }
+    }
+}
+
+void quantizeVertices(const SourceVertex* src, Vertex* dst, size_t count)
+{
+    // 纹理坐标限制在 [0, 1]，超出范围的网格需要保留浮点格式
+    size_t i = 0;
+
+#ifdef USE_SSE2
+    static_assert(sizeof(SourceVertex) == 7 * sizeof(float), "unexpected SourceVertex layout!");
+    static_assert(sizeof(Vertex) == 3 * sizeof(uint32_t), "unexpected Vertex layout!");
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 unorm16 = _mm_set1_ps(65535.0f);
+    const __m128 unorm8 = _mm_set1_ps(255.0f);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(0xFF000000));
+
+    // 一次处理 4 个顶点：每个源顶点 7 个浮点数，前 4 个与后 4 个各读取一次，转置后每个向量为同一分量
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* v = reinterpret_cast<const float*>(src + i);
+
+        __m128 posX = _mm_loadu_ps(v + 0), posY = _mm_loadu_ps(v + 7), red = _mm_loadu_ps(v + 14), green = _mm_loadu_ps(v + 21);
+        _MM_TRANSPOSE4_PS(posX, posY, red, green);
+
+        __m128 unused = _mm_loadu_ps(v + 3), blue = _mm_loadu_ps(v + 10), texU = _mm_loadu_ps(v + 17), texV = _mm_loadu_ps(v + 24);
+        _MM_TRANSPOSE4_PS(unused, blue, texU, texV);
+
+        // 每个 32 位通道是一个顶点的一个成员
+        __m128i pos = _mm_or_si128(floatToHalf4(posX), _mm_slli_epi32(floatToHalf4(posY), 16));
+
+        __m128i s = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(texU, zero), one), unorm16));
+        __m128i t = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(texV, zero), one), unorm16));
+        __m128i texCoord = _mm_or_si128(s, _mm_slli_epi32(t, 16));
+
+        __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(red, zero), one), unorm8));
+        __m128i g = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(green, zero), one), unorm8));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(blue, zero), one), unorm8));
+        __m128i color = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+
+        // 转置回按顶点排列，每行 12 字节有效；前 3 行多写的 4 字节由下一个顶点覆盖
+        __m128 row0 = _mm_castsi128_ps(pos), row1 = _mm_castsi128_ps(texCoord), row2 = _mm_castsi128_ps(color), row3 = zero;
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
 
-    if (vkAllocateCommandBuffers(myDevice, &allocInfo, myCommandBuffers.data()) != VK_SUCCESS)
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + i + 0), row0);
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + i + 1), row1);
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + i + 2), row2);
+        memcpy(dst + i + 3, &row3, sizeof(Vertex));
+    }
+#endif
+
+    // 剩余的顶点逐个转换
+    for (; i < count; i++)
     {
-        throw runtime_error("failed to allocate command buffers!");
+        dst[i].pos = { floatToHalf(src[i].pos.x), floatToHalf(src[i].pos.y) };
+        dst[i].texCoord = { floatToUnorm16(src[i].texCoord.x), floatToUnorm16(src[i].texCoord.y) };
+        dst[i].color = { floatToUnorm8(src[i].color.x), floatToUnorm8(src[i].color.y), floatToUnorm8(src[i].color.z), 255 };
     }
 }
 
 void createVertexBuffer() 
 {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    // 网格文件已经是压缩格式时直接从映射内存上传，否则先量化浮点顶点
+    const SourceVertex* sourceVertices = vertices.data();
+    size_t vertexCount = vertices.size();
 
-    // ݴ滺
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    const void* vertexData = nullptr;
+    VkDeviceSize bufferSize = 0;
+    vector<Vertex> quantized{};
 
-    void* data;
-    vkMapMemory(myDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(myDevice, stagingBufferMemory);
+    if (myMesh.header != nullptr)
+    {
+        if (matchesVertexLayout<Vertex>(myMesh))
+        {
+            vertexData = myMesh.vertexData;
+            bufferSize = myMesh.header->vertexCount * myMesh.header->vertexStride;
+        }
+        else if (matchesVertexLayout<SourceVertex>(myMesh))
+        {
+            sourceVertices = static_cast<const SourceVertex*>(myMesh.vertexData);
+            vertexCount = static_cast<size_t>(myMesh.header->vertexCount);
+        }
+        else throw runtime_error("mesh vertex layout does not match pipeline!");
+    }
 
-    // 㻺
-    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, myVertexBuffer, myVertexBufferMemory);
+    if (vertexData == nullptr)
+    {
+        quantized.resize(vertexCount);
+        quantizeVertices(sourceVertices, quantized.data(), vertexCount);
+
+        vertexData = quantized.data();
+        bufferSize = sizeof(Vertex) * vertexCount;
 
-    // ݴݴ滺ƶ㻺
-    copyBuffer(stagingBuffer, myVertexBuffer, bufferSize);
+        cout << "Vertices: " << vertexCount << " quantized, " << sizeof(SourceVertex) << " -> " << sizeof(Vertex) << " bytes per vertex" << endl;
+    }
 
-    // ͷݴ滺
-    vkDestroyBuffer(myDevice, stagingBuffer, nullptr);
-    vkFreeMemory(myDevice, stagingBufferMemory, nullptr);
+    // 统一内存 或 可调整大小的 BAR 时放在 CPU 可见的显存中
+    MemoryUsage memoryUsage = myDirectUploadSupported ? MEMORY_USAGE_DYNAMIC : MEMORY_USAGE_GPU_ONLY;
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, memoryUsage, myVertexBuffer, myVertexBufferMemory);
+
+    // 直接写入，或者通过暂存环形缓冲区将数据上传到顶点缓冲区
+    uploadBuffer(myVertexBuffer, myVertexBufferMemory, vertexData, bufferSize);
 }
 
 void createIndexBuffer() 
 {
+    const void* indexData = indices.data();
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-    // ݴ滺
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(myDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(myDevice, stagingBufferMemory);
+    if (myMesh.header != nullptr)
+    {
+        indexData = myMesh.indexData;
+        bufferSize = myMesh.header->indexCount * myMesh.header->indexSize;
+    }
+    else
+    {
+        // 硬编码索引作为一个子网格
+        MeshSubmesh submesh{};
+        submesh.indexCount = static_cast<uint32_t>(indices.size());
 
-    // 
-    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, myIndexBuffer, myIndexBufferMemory);
+        myIndexType = VK_INDEX_TYPE_UINT16;
+        mySubmeshes.assign(1, submesh);
+        mySceneVersion++;
+    }
 
-    // ݴݴ滺ƶ
-    copyBuffer(stagingBuffer, myIndexBuffer, bufferSize);
+    // 统一内存 或 可调整大小的 BAR 时放在 CPU 可见的显存中
+    MemoryUsage memoryUsage = myDirectUploadSupported ? MEMORY_USAGE_DYNAMIC : MEMORY_USAGE_GPU_ONLY;
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryUsage, myIndexBuffer, myIndexBufferMemory);
 
-    // ͷݴ滺
-    vkDestroyBuffer(myDevice, stagingBuffer, nullptr);
-    vkFreeMemory(myDevice, stagingBufferMemory, nullptr);
+    // 直接写入，或者通过暂存环形缓冲区将数据上传到索引缓冲区
+    uploadBuffer(myIndexBuffer, myIndexBufferMemory, indexData, bufferSize);
 }
\ No newline at end of file
@@ -1,34 +1,42 @@
 /// <summary>
 /// 
-///  ͬ | ֡ |  | ͼ |  |  
+///  同步物体 | 帧缓冲区 | 命令池 | 纹理图像 | 描述布局 | 描述集 
 /// 
 /// </summary>
 
 #include <vector>
 #include <chrono>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 using namespace std;
 // ##############################################################
 
 // UBO
+// 每帧一次的数据，模型矩阵通过推送常量传递
 struct UniformBufferObject
 {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
 };
 
+// 描述集更新模板读取的数据，成员顺序与描述布局的绑定一致
+struct FrameDescriptorData
+{
+    VkDescriptorBufferInfo uniformBuffer; // binding 0
+    VkDescriptorImageInfo texture; // binding 1
+};
+
 // ##############################################################
-void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) 
+void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, MemoryUsage memoryUsage, VkImage& image, MemoryAllocation& imageMemory) 
 {
-    // ָʽͼ
+    // 创建指定格式的图像
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -39,30 +47,23 @@ void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling
 
     if (vkCreateImage(myDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) throw runtime_error("failed to create image!");
 
-    // ȡҪĻڴϢ
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(myDevice, image, &memRequirements);
+    // 获取需要的图像内存信息
+    bool prefersDedicated = false;
+    VkMemoryRequirements memRequirements = getImageMemoryRequirements(image, prefersDedicated);
 
-    // Ϊָ͵ڴ
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    // 为图像分配指定用途的内存，大图像 或 驱动希望独占时使用独立分配
+    bool linear = tiling == VK_IMAGE_TILING_LINEAR;
+    bool dedicated = prefersDedicated || memRequirements.size >= const_dedicatedImageSize;
+    imageMemory = allocateMemory(memRequirements, memoryUsage, linear, dedicated, image);
 
-    if (vkAllocateMemory(myDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) throw runtime_error("failed to allocate image memory!");
-
-    // ڴ浽ָ
-    vkBindImageMemory(myDevice, image, imageMemory, 0);
+    // 绑定内存到指定图像
+    vkBindImageMemory(myDevice, image, imageMemory.memory, imageMemory.offset);
 }
 
-void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) 
+void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) 
 {
-    //  
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    // ͼڴ汣
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    // 创建图像内存保护区
+    VkImageMemoryBarrier2 barrier{};
     barrier.oldLayout = oldLayout;
     barrier.newLayout = newLayout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -70,60 +71,42 @@ void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayo
     barrier.image = image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
 
-    // ݹ߽׶ͼ񲼾
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
+    // 根据两个布局的常见用途设置阶段与访问类型，之前的读取只需要执行依赖
+    const ResourceUsageInfo& source = const_resourceUsages[getLayoutUsage(oldLayout)];
+    const ResourceUsageInfo& destination = const_resourceUsages[getLayoutUsage(newLayout)];
 
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
-    {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcStageMask = source.stage;
+    barrier.srcAccessMask = source.write ? source.access : 0;
+    barrier.dstStageMask = destination.stage;
+    barrier.dstAccessMask = destination.access;
 
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) 
-    {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    // 这里的传输布局只用于缓冲区到图像的拷贝，只需要等待或阻塞拷贝阶段
+    if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
 
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    else throw invalid_argument("unsupported layout transition!");
-
-    vkCmdPipelineBarrier
-    (
-        commandBuffer,
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-
-    //  յ
-    endSingleTimeCommands(commandBuffer);
+    // 排队到下一条拷贝之前；着色器读取发生在图形队列上，需要时转移所有权
+    if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) queueImageBarrier(myUploadBarriers, barrier);
+    else releaseImage(barrier);
 }
 
-void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) 
+void copyBufferToImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t mipLevel, uint32_t width, uint32_t height, uint32_t rowOffset) 
 {
-    //  
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    // 录制到当前上传批次
+    VkCommandBuffer commandBuffer = getUploadCommandBuffer();
 
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = mipLevel;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
-    region.imageOffset = { 0, 0, 0 };
+    region.imageOffset = { 0, static_cast<int32_t>(rowOffset), 0 };
     region.imageExtent = 
     {
         width,
@@ -131,28 +114,90 @@ void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
         1
     };
 
-    // ָָƵӦͼ
+    // 将缓冲区的指定部分复制到对应图像
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+void uploadImage(VkImage image, uint32_t mipLevel, const void* pixels, uint32_t width, uint32_t height, uint32_t blockExtent, uint32_t blockSize)
+{
+    // 按压缩块的行分块（未压缩时块为 1x1 像素），保证每一块都能放进暂存环形缓冲区
+    uint32_t blocksHigh = (height + blockExtent - 1) / blockExtent;
+    VkDeviceSize rowSize = static_cast<VkDeviceSize>((width + blockExtent - 1) / blockExtent) * blockSize;
+    uint32_t maxRows = static_cast<uint32_t>(min<VkDeviceSize>(blocksHigh, const_stagingBufferSize / rowSize));
+
+    // 每块总是覆盖整个宽度；起始行与行数需要是传输队列拷贝粒度的倍数，最后一块到达图像底边时除外
+    // 粒度为 0 的队列只能拷贝整个层级
+    uint32_t granularity = myTransferGranularity.height;
+    if (granularity == 0)
+    {
+        if (maxRows < blocksHigh) throw runtime_error("image level larger than staging buffer on a queue without partial image copies!");
+    }
+    else if (maxRows < blocksHigh) maxRows -= maxRows % granularity;
+
+    if (maxRows == 0) throw runtime_error("image row larger than staging buffer!");
+
+    for (uint32_t row = 0; row < blocksHigh; row += maxRows)
+    {
+        uint32_t rows = min(maxRows, blocksHigh - row);
+        VkDeviceSize chunkSize = rows * rowSize;
 
-    //  յ
-    endSingleTimeCommands(commandBuffer);
+        // 缓冲区偏移需要同时是 4 和 块大小 的倍数
+        VkDeviceSize stagingOffset = allocateStaging(chunkSize, blockSize * 4);
+
+        memcpy(static_cast<char*>(myStagingBufferMemory.mapped) + stagingOffset, static_cast<const char*>(pixels) + row * rowSize, static_cast<size_t>(chunkSize));
+
+        // 最后一行块可以超出图像边缘，拷贝范围截断到图像高度
+        uint32_t rowOffset = row * blockExtent;
+        copyBufferToImage(myStagingBuffer, stagingOffset, image, mipLevel, width, min(rows * blockExtent, height - rowOffset), rowOffset);
+    }
+}
+
+uint32_t allocateUniform(uint32_t currentImage, const void* data, VkDeviceSize size)
+{
+    // 在当前帧的环形区中分配一个对齐的切片并写入数据，返回动态偏移
+    VkDeviceSize offset = myUniformRingHead;
+    if (offset + size > myUniformRingSize) throw runtime_error("uniform ring buffer overflow!");
+
+    memcpy(static_cast<char*>(myUniformBuffersMapped[currentImage]) + offset, data, (size_t)size);
+    myUniformRingHead = alignUp(offset + size, myUniformAlignment);
+
+    return static_cast<uint32_t>(offset);
 }
 
 void updateUniformBuffer(uint32_t currentImage) 
 {
-    // ͳһݣʵת
+    // 该帧上一次提交的时间线值已经等待过，环形区可以从头复用
+    myUniformRingHead = 0;
+
+    // 更新统一缓冲区数据，以实现物体旋转
     static auto startTime = std::chrono::high_resolution_clock::now();
 
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
+    // 相机绕 z 轴反向旋转，画面与旋转模型相同；动画只改变统一缓冲区，不改变录制的命令
+    glm::mat4 orbit = glm::rotate(glm::mat4(1.0f), -time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::vec3 eye = glm::vec3(orbit * glm::vec4(2.0f, 2.0f, 2.0f, 1.0f));
+
     UniformBufferObject ubo{};
-    ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    ubo.view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     ubo.proj = glm::perspective(glm::radians(45.0f), mySwapChainExtent.width / (float)mySwapChainExtent.height, 0.1f, 10.0f);
     ubo.proj[1][1] *= -1;
 
-    memcpy(myUniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+    // 整帧共用环形区中的一个切片
+    myFrameUniformOffset = allocateUniform(currentImage, &ubo, sizeof(ubo));
+
+    // 每个物体只记录模型矩阵，录制时作为推送常量写入
+    vector<glm::mat4> transforms{};
+    transforms.push_back(glm::mat4(1.0f));
+
+    // 推送常量录制在命令缓冲区中，模型矩阵变化时需要重新录制
+    bool changed = transforms.size() != myObjectTransforms.size() || memcmp(transforms.data(), myObjectTransforms.data(), transforms.size() * sizeof(glm::mat4)) != 0;
+    if (changed)
+    {
+        myObjectTransforms.swap(transforms);
+        mySceneVersion++;
+    }
 }
 // ##############################################################
 
@@ -160,21 +205,15 @@ void createSyncObjects()
 {
     myImageAvailableSemaphores.resize(const_maxFrames);
     myRenderFinishedSemaphores.resize(const_maxFrames);
-    myInFlightFences.resize(const_maxFrames);
 
-    // ڼź
+    // 交换链只接受二值信号量，帧的完成由图形队列时间线跟踪
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (int num = 0; num < const_maxFrames; num++)
     {
         if (vkCreateSemaphore(myDevice, &semaphoreInfo, nullptr, &myImageAvailableSemaphores[num]) != VK_SUCCESS ||
-            vkCreateSemaphore(myDevice, &semaphoreInfo, nullptr, &myRenderFinishedSemaphores[num]) != VK_SUCCESS ||
-            vkCreateFence(myDevice, &fenceInfo, nullptr, &myInFlightFences[num]) != VK_SUCCESS)
+            vkCreateSemaphore(myDevice, &semaphoreInfo, nullptr, &myRenderFinishedSemaphores[num]) != VK_SUCCESS)
         {
             throw runtime_error("failed to create synchronization objects for a frame!");
         }
@@ -185,7 +224,7 @@ void createFramebuffers()
 {
     mySwapChainFramebuffers.resize(mySwapChainImageViews.size());
 
-    // Ϊÿ ͼͼ һ֡
+    // 为每个 图像视图 创建一个帧缓冲区
     for (size_t i = 0; i < mySwapChainImageViews.size(); i++)
     {
         VkImageView attachments[] =
@@ -211,56 +250,216 @@ void createFramebuffers()
 
 void createCommandPool()
 {
-    //  صȫ ͼζ
+    // 设置 该命令池的命令全都来自 图形队列
     QueueFamilyIndices queueFamilyIndices = findQueueFamilies(myPhysicalDevice);
 
+    // 每帧一个命令池，帧开始时整体重置，不单独重置命令缓冲区
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
-    if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myCommandPool) != VK_SUCCESS)
+    myCommandPools.resize(const_maxFrames);
+    for (uint32_t frame = 0; frame < const_maxFrames; frame++)
     {
-        throw runtime_error("failed to create command pool!");
+        if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myCommandPools[frame]) != VK_SUCCESS)
+        {
+            throw runtime_error("failed to create command pool!");
+        }
+    }
+}
+
+bool supportsLinearBlit(VkFormat format)
+{
+    // 检查图像格式是否支持线性过滤的 blit
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(myPhysicalDevice, format, &formatProperties);
+
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    return (formatProperties.optimalTilingFeatures & features) == features;
+}
+
+void generateMipmaps(VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
+{
+    // blit 需要图形队列，必要时先将整个图像的所有权转移给图形队列
+    VkImageMemoryBarrier2 barrier{};
+    barrier.image = image;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    releaseImage(barrier);
+
+    // 所有权转移与之后的布局转换不能在同一次屏障中，先记录
+    BarrierBatcher& barriers = getGraphicsUploadBarriers();
+    VkCommandBuffer commandBuffer = getGraphicsUploadCommandBuffer();
+
+    // 之后每次只处理一个层级
+    barrier.subresourceRange.levelCount = 1;
+
+    int32_t mipWidth = texWidth;
+    int32_t mipHeight = texHeight;
+
+    for (uint32_t i = 1; i < mipLevels; i++)
+    {
+        // 上一级写入完成后转为 blit 的源
+        barrier.subresourceRange.baseMipLevel = i - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+        // 与上一级转为着色器只读的屏障一起记录
+        queueImageBarrier(barriers, barrier);
+        flushBarriers(barriers, commandBuffer);
+
+        // 将上一级缩小一半写入当前级
+        VkImageBlit blit{};
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+
+        vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        // 上一级不再使用，转为着色器只读
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+
+        queueImageBarrier(barriers, barrier);
+
+        if (mipWidth > 1) mipWidth /= 2;
+        if (mipHeight > 1) mipHeight /= 2;
+    }
+
+    // 最后一级只被写入，直接转为着色器只读
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+
+    // 留在队列中，与下一张纹理的屏障或提交前的屏障一起记录
+    queueImageBarrier(barriers, barrier);
+}
+
+void createCompressedTextureImage(const TextureData& texture)
+{
+    // 预压缩的多级渐远纹理逐级直接上传，不解码也不再生成
+    myTextureFormat = texture.format;
+    myTextureMipLevels = static_cast<uint32_t>(texture.levels.size());
+
+    createImage(texture.width, texture.height, myTextureMipLevels, myTextureFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, MEMORY_USAGE_GPU_ONLY, myTextureImage, myTextureImageMemory);
+
+    transitionImageLayout(myTextureImage, myTextureFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, myTextureMipLevels);
+
+    for (uint32_t i = 0; i < myTextureMipLevels; i++)
+    {
+        const TextureLevel& level = texture.levels[i];
+        uploadImage(myTextureImage, i, texture.bytes.data() + level.offset, level.width, level.height, texture.blockExtent, texture.blockSize);
+    }
+
+    transitionImageLayout(myTextureImage, myTextureFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, myTextureMipLevels);
+}
+
+void createTextureImageFromPixels(const stbi_uc* pixels, uint32_t width, uint32_t height)
+{
+    // 回退到 RGBA8，生成完整的多级渐远纹理链
+    myTextureFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    myTextureMipLevels = getMipLevels(width, height);
+
+    // 生成多级渐远纹理时各级也作为 blit 的源
+    createImage(width, height, myTextureMipLevels, myTextureFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, MEMORY_USAGE_GPU_ONLY, myTextureImage, myTextureImageMemory);
+
+    // 通过暂存环形缓冲区上传像素
+    transitionImageLayout(myTextureImage, myTextureFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, myTextureMipLevels);
+    uploadImage(myTextureImage, 0, pixels, width, height, 1, 4);
+
+    if (supportsLinearBlit(myTextureFormat))
+    {
+        // 在 GPU 上逐级 blit 生成，结束时所有层级都是着色器只读
+        generateMipmaps(myTextureImage, static_cast<int32_t>(width), static_cast<int32_t>(height), myTextureMipLevels);
+    }
+    else
+    {
+        // 格式不支持线性 blit 时，在 CPU 上多线程降采样后逐级上传
+        vector<vector<uint8_t>> levels = buildMipChain(pixels, width, height, myTextureMipLevels);
+
+        for (uint32_t i = 1; i < myTextureMipLevels; i++)
+        {
+            uploadImage(myTextureImage, i, levels[i - 1].data(), max(width >> i, 1u), max(height >> i, 1u), 1, 4);
+        }
+
+        transitionImageLayout(myTextureImage, myTextureFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, myTextureMipLevels);
     }
 }
 
 void createTextureImage() 
 {
-    // ȡͼϢ
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load("Pic0.png", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
+    AssetTiming timing{};
 
-    if (!pixels) throw runtime_error("failed to load texture image!");
+    // 优先使用设备支持的预压缩纹理，启动时请求的 PNG 解码结果随解码线程一起释放
+    TextureData texture{};
+    if (loadCompressedTexture(texture))
+    {
+        auto start = chrono::high_resolution_clock::now();
+        createCompressedTextureImage(texture);
 
-    // ݴ滺
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        timing.name = texture.filename;
+        timing.uploadMs = elapsedMs(start);
+        myAssetTimings.push_back(timing);
+        return;
+    }
 
-    void* data;
-    vkMapMemory(myDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(myDevice, stagingBufferMemory);
+    // 获取 工作线程解码完成的图像
+    DecodedImage image = waitDecoded(timing.waitMs);
 
-    // ֵ
-    stbi_image_free(pixels);
+    if (!image.pixels) throw runtime_error("failed to load texture image!");
 
-    createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, myTextureImage, myTextureImageMemory);
+    auto start = chrono::high_resolution_clock::now();
+    createTextureImageFromPixels(image.pixels, static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height));
 
-    transitionImageLayout(myTextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(stagingBuffer, myTextureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    transitionImageLayout(myTextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    timing.name = image.filename;
+    timing.decodeMs = image.decodeMs;
+    timing.uploadMs = elapsedMs(start);
+    myAssetTimings.push_back(timing);
 
-    vkDestroyBuffer(myDevice, stagingBuffer, nullptr);
-    vkFreeMemory(myDevice, stagingBufferMemory, nullptr);
+    // 清理像素值
+    stbi_image_free(image.pixels);
 }
 
 void createTextureImageView() 
 {
-    // Ϊͼ󴴽ָʽͼͼ
-    myTextureImageView = createImageView(myTextureImage, VK_FORMAT_R8G8B8A8_SRGB);
+    // 为图像对象创建指定格式的图像视图
+    myTextureImageView = createImageView(myTextureImage, myTextureFormat, myTextureMipLevels);
 }
 
 void createTextureSampler() 
@@ -282,38 +481,49 @@ void createTextureSampler()
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(myTextureMipLevels);
+    samplerInfo.mipLodBias = 0.0f;
 
     if (vkCreateSampler(myDevice, &samplerInfo, nullptr, &myTextureSampler) != VK_SUCCESS) throw runtime_error("failed to create texture sampler!");
 }
 
 void createUniformBuffers()
 {
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+    // 动态偏移必须是 minUniformBufferOffsetAlignment 的倍数
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(myPhysicalDevice, &properties);
+
+    myUniformAlignment = alignUp(sizeof(UniformBufferObject), properties.limits.minUniformBufferOffsetAlignment);
+
+    myUniformRingSize = myUniformAlignment * const_uniformRingSlices;
+    VkDeviceSize bufferSize = myUniformRingSize;
 
     myUniformBuffers.resize(const_maxFrames);
     myUniformBuffersMemory.resize(const_maxFrames);
     myUniformBuffersMapped.resize(const_maxFrames);
 
-    // Ϊ֡һ ͳһ
+    // 为所有帧都设置一个 常驻映射的统一缓冲环形区
     for (size_t i = 0; i < const_maxFrames; i++)
     {
-        createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, myUniformBuffers[i], myUniformBuffersMemory[i]);
+        // 每帧由 CPU 写入，可用时放在 CPU 可见的显存中
+        createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, MEMORY_USAGE_DYNAMIC, myUniformBuffers[i], myUniformBuffersMemory[i]);
 
-        vkMapMemory(myDevice, myUniformBuffersMemory[i], 0, bufferSize, 0, &myUniformBuffersMapped[i]);
+        myUniformBuffersMapped[i] = myUniformBuffersMemory[i].mapped;
     }
 }
 
 void createDescriptorSetLayout() 
 {
-    //  Ӧ UBO
+    // 设置 描述符对应的 UBO
     VkDescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.binding = 0;
     uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     uboLayoutBinding.pImmutableSamplers = nullptr;
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-    //  ӦĲ
+    // 设置 描述符对应的采样器
     VkDescriptorSetLayoutBinding samplerLayoutBinding{};
     samplerLayoutBinding.binding = 1;
     samplerLayoutBinding.descriptorCount = 1;
@@ -330,69 +540,55 @@ void createDescriptorSetLayout()
     if (vkCreateDescriptorSetLayout(myDevice, &layoutInfo, nullptr, &myDescriptorSetLayout) != VK_SUCCESS) throw runtime_error("failed to create descriptor set layout!");
 }
 
-void createDescriptorPool() 
+void createDescriptorUpdateTemplate()
 {
-    // شС
-    array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(const_maxFrames);
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(const_maxFrames);
-
-    // شϢ
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(const_maxFrames);
-
-    if (vkCreateDescriptorPool(myDevice, &poolInfo, nullptr, &myDescriptorPool) != VK_SUCCESS) throw runtime_error("failed to create descriptor pool!");
+    // 模板中的每一项按偏移从 FrameDescriptorData 读取
+    array<VkDescriptorUpdateTemplateEntry, 2> entries{};
+
+    entries[0].dstBinding = 0;
+    entries[0].dstArrayElement = 0;
+    entries[0].descriptorCount = 1;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    entries[0].offset = offsetof(FrameDescriptorData, uniformBuffer);
+    entries[0].stride = sizeof(VkDescriptorBufferInfo);
+
+    entries[1].dstBinding = 1;
+    entries[1].dstArrayElement = 0;
+    entries[1].descriptorCount = 1;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    entries[1].offset = offsetof(FrameDescriptorData, texture);
+    entries[1].stride = sizeof(VkDescriptorImageInfo);
+
+    VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+    templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    templateInfo.pDescriptorUpdateEntries = entries.data();
+    templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    templateInfo.descriptorSetLayout = myDescriptorSetLayout;
+
+    if (vkCreateDescriptorUpdateTemplate(myDevice, &templateInfo, nullptr, &myDescriptorUpdateTemplate) != VK_SUCCESS) throw runtime_error("failed to create descriptor update template!");
 }
 
 void createDescriptorSets() 
 {
-    // ضӦ
-    vector<VkDescriptorSetLayout> layouts(const_maxFrames, myDescriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = myDescriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(const_maxFrames);
-    allocInfo.pSetLayouts = layouts.data();
-
+    // 为每一帧获取一个描述集，内容相同的描述集只写入一次
     descriptorSets.resize(const_maxFrames);
-    if (vkAllocateDescriptorSets(myDevice, &allocInfo, descriptorSets.data()) != VK_SUCCESS) throw runtime_error("failed to allocate descriptor sets!");
 
-    // Ϊÿһ֡һ
     for (size_t i = 0; i < const_maxFrames; i++) 
     {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = myUniformBuffers[i];
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(UniformBufferObject);
-
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = myTextureImageView;
-        imageInfo.sampler = myTextureSampler;
-
-        array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = descriptorSets[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = descriptorSets[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &imageInfo;
-
-        vkUpdateDescriptorSets(myDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        // 清零填充字节，缓存按字节比较
+        FrameDescriptorData data;
+        memset(&data, 0, sizeof(data));
+
+        // 描述符只覆盖一个切片，绘制时通过动态偏移选择
+        data.uniformBuffer.buffer = myUniformBuffers[i];
+        data.uniformBuffer.offset = 0;
+        data.uniformBuffer.range = sizeof(UniformBufferObject);
+
+        data.texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        data.texture.imageView = myTextureImageView;
+        data.texture.sampler = myTextureSampler;
+
+        descriptorSets[i] = getDescriptorSet(myDescriptorCache, myDescriptorSetLayout, myDescriptorUpdateTemplate, &data, sizeof(data));
     }
 }
\ No newline at end of file
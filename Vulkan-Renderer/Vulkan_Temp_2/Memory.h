@@ -0,0 +1,431 @@
+/// <summary>
+/// 
+///  内存类型 | 用途策略 | 内存块 | 子分配 | 独立分配 | 分配统计
+/// 
+/// </summary>
+
+#include <bitset>
+#include <list>
+#include <map>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 每个内存块的默认大小
+const VkDeviceSize const_memoryBlockSize = 64ull * 1024 * 1024;
+
+// 超过该大小的图像使用独立分配
+const VkDeviceSize const_dedicatedImageSize = 16ull * 1024 * 1024;
+
+// BAR 窗口的典型大小，超过该大小的 DEVICE_LOCAL|HOST_VISIBLE 堆视为可调整大小的 BAR
+const VkDeviceSize const_smallBarHeapSize = 256ull * 1024 * 1024;
+
+// 内存用途：决定内存类型的必需、偏好和回避属性
+enum MemoryUsage
+{
+    MEMORY_USAGE_GPU_ONLY, // 只由 GPU 访问，例如纹理、经暂存上传的顶点
+    MEMORY_USAGE_UPLOAD, // CPU 顺序写入、GPU 读取一次，例如暂存缓冲区
+    MEMORY_USAGE_READBACK, // GPU 写入、CPU 读取
+    MEMORY_USAGE_DYNAMIC // CPU 频繁写入、GPU 频繁读取，例如统一缓冲区
+};
+
+// 内存块：一次 vkAllocateMemory 得到的大块内存，由多个资源共享
+struct MemoryBlock
+{
+    VkDeviceMemory memory = nullptr;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // 主机可见内存块常驻映射
+
+    map<VkDeviceSize, VkDeviceSize> freeRanges{}; // 空闲区间：偏移 -> 大小
+    uint32_t allocationCount = 0;
+};
+
+// 分配统计
+struct MemoryStatistics
+{
+    uint32_t blockCount = 0; // 内存块数量
+    uint32_t dedicatedCount = 0; // 独立分配数量
+    uint32_t allocationCount = 0; // 子分配数量
+    VkDeviceSize blockBytes = 0; // 内存块总大小
+    VkDeviceSize dedicatedBytes = 0; // 独立分配总大小
+    VkDeviceSize usedBytes = 0; // 子分配实际使用的大小
+};
+
+VkPhysicalDeviceMemoryProperties myMemoryProperties{};
+VkDeviceSize myBufferImageGranularity = 1;
+uint32_t myMaxMemoryAllocationCount = 0;
+uint32_t myDeviceMemoryCount = 0;
+
+// 统一内存架构 或 可调整大小的 BAR：大块 DEVICE_LOCAL 内存可由 CPU 直接写入
+bool myDirectUploadSupported = false;
+
+// 按 内存类型 和 资源种类(0 线性 / 1 非线性) 划分的内存块
+list<MemoryBlock> myMemoryBlocks[VK_MAX_MEMORY_TYPES][2];
+
+MemoryStatistics myMemoryStatistics{};
+
+// ##############################################################
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t findMemoryType(uint32_t typeFilter, MemoryUsage usage)
+{
+    VkMemoryPropertyFlags required = 0;
+    VkMemoryPropertyFlags preferred = 0;
+    VkMemoryPropertyFlags avoided = 0;
+
+    // 根据用途设置属性
+    switch (usage)
+    {
+    case MEMORY_USAGE_GPU_ONLY:
+        preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        break;
+    case MEMORY_USAGE_UPLOAD:
+        // 暂存数据不占用稀缺的 BAR 窗口
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    case MEMORY_USAGE_READBACK:
+        // 读取未缓存的内存非常慢
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        break;
+    case MEMORY_USAGE_DYNAMIC:
+        // 优先 GPU 本地且 CPU 可见，否则退化为系统内存
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    }
+
+    // 不使用特殊用途的内存类型
+    avoided |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD;
+
+    // 为满足必需属性的内存类型打分：偏好属性优先，回避属性次之，同分时取序号小的
+    int bestIndex = -1;
+    int bestScore = 0;
+
+    for (uint32_t i = 0; i < myMemoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags flags = myMemoryProperties.memoryTypes[i].propertyFlags;
+
+        if (!(typeFilter & (1 << i)) || (flags & required) != required) continue;
+
+        int score = 2 * static_cast<int>(bitset<32>(flags & preferred).count()) - static_cast<int>(bitset<32>(flags & avoided).count());
+        if (bestIndex < 0 || score > bestScore)
+        {
+            bestIndex = static_cast<int>(i);
+            bestScore = score;
+        }
+    }
+
+    if (bestIndex < 0) throw runtime_error("failed to find suitable memory type!");
+
+    return static_cast<uint32_t>(bestIndex);
+}
+
+void freeDeviceMemory(VkDeviceMemory memory)
+{
+    // 映射的内存在释放时自动解除映射
+    vkFreeMemory(myDevice, memory, nullptr);
+    myDeviceMemoryCount--;
+}
+
+VkMemoryRequirements getBufferMemoryRequirements(VkBuffer buffer, bool& prefersDedicated)
+{
+    // 同时查询驱动是否希望该资源独占一次分配
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memRequirements{};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+
+    VkBufferMemoryRequirementsInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    info.buffer = buffer;
+
+    vkGetBufferMemoryRequirements2(myDevice, &info, &memRequirements);
+
+    prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    return memRequirements.memoryRequirements;
+}
+
+VkMemoryRequirements getImageMemoryRequirements(VkImage image, bool& prefersDedicated)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memRequirements{};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+
+    VkImageMemoryRequirementsInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    info.image = image;
+
+    vkGetImageMemoryRequirements2(myDevice, &info, &memRequirements);
+
+    prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    return memRequirements.memoryRequirements;
+}
+
+VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped, VkImage dedicatedImage = VK_NULL_HANDLE, VkBuffer dedicatedBuffer = VK_NULL_HANDLE)
+{
+    // 驱动对 vkAllocateMemory 的次数有上限
+    if (myDeviceMemoryCount >= myMaxMemoryAllocationCount) throw runtime_error("exceeded maxMemoryAllocationCount!");
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    // 整块内存只绑定一个资源时告知驱动，便于其选择更优的布局
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.image = dedicatedImage;
+    dedicatedInfo.buffer = dedicatedBuffer;
+
+    if (dedicatedImage != VK_NULL_HANDLE || dedicatedBuffer != VK_NULL_HANDLE) allocInfo.pNext = &dedicatedInfo;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(myDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) throw runtime_error("failed to allocate device memory!");
+
+    myDeviceMemoryCount++;
+
+    // 主机可见内存在整个生命周期内保持映射
+    *mapped = nullptr;
+    if (myMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(myDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+        {
+            freeDeviceMemory(memory);
+            throw runtime_error("failed to map device memory!");
+        }
+    }
+
+    return memory;
+}
+
+bool allocateFromBlock(MemoryBlock& block, const VkMemoryRequirements& memRequirements, MemoryAllocation& allocation)
+{
+    // 最佳适配：选取能容纳请求的最小空闲区间
+    auto best = block.freeRanges.end();
+    VkDeviceSize bestOffset = 0;
+
+    for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); range++)
+    {
+        VkDeviceSize offset = alignUp(range->first, memRequirements.alignment);
+        if (offset + memRequirements.size > range->first + range->second) continue;
+
+        if (best == block.freeRanges.end() || range->second < best->second)
+        {
+            best = range;
+            bestOffset = offset;
+        }
+    }
+
+    if (best == block.freeRanges.end()) return false;
+
+    // 拆分空闲区间，保留对齐前后的剩余部分
+    VkDeviceSize rangeOffset = best->first;
+    VkDeviceSize rangeEnd = best->first + best->second;
+    block.freeRanges.erase(best);
+
+    if (bestOffset > rangeOffset) block.freeRanges[rangeOffset] = bestOffset - rangeOffset;
+    if (bestOffset + memRequirements.size < rangeEnd) block.freeRanges[bestOffset + memRequirements.size] = rangeEnd - bestOffset - memRequirements.size;
+
+    allocation.memory = block.memory;
+    allocation.offset = bestOffset;
+    allocation.size = memRequirements.size;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + bestOffset : nullptr;
+    allocation.block = &block;
+
+    block.allocationCount++;
+
+    return true;
+}
+
+MemoryAllocation allocateMemory(const VkMemoryRequirements& memRequirements, MemoryUsage usage, bool linear, bool dedicated, VkImage image = VK_NULL_HANDLE, VkBuffer buffer = VK_NULL_HANDLE)
+{
+    MemoryAllocation allocation{};
+    allocation.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, usage);
+
+    // 单个内存块不超过所在堆的 1/8，避免小堆被一次占满
+    uint32_t heapIndex = myMemoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex;
+    VkDeviceSize blockSize = min(const_memoryBlockSize, myMemoryProperties.memoryHeaps[heapIndex].size / 8);
+
+    // 大资源 或 驱动希望独占的资源直接使用独立分配
+    if (dedicated || memRequirements.size > blockSize / 2)
+    {
+        allocation.memory = allocateDeviceMemory(memRequirements.size, allocation.memoryTypeIndex, &allocation.mapped, image, buffer);
+        allocation.offset = 0;
+        allocation.size = memRequirements.size;
+        allocation.block = nullptr;
+
+        myMemoryStatistics.dedicatedCount++;
+        myMemoryStatistics.dedicatedBytes += memRequirements.size;
+
+        return allocation;
+    }
+
+    // bufferImageGranularity 大于 1 时，线性与非线性资源放在不同的内存块中，互不相邻
+    list<MemoryBlock>& blocks = myMemoryBlocks[allocation.memoryTypeIndex][(!linear && myBufferImageGranularity > 1) ? 1 : 0];
+
+    bool allocated = false;
+    for (auto& block : blocks)
+    {
+        if (allocateFromBlock(block, memRequirements, allocation))
+        {
+            allocated = true;
+            break;
+        }
+    }
+
+    // 现有内存块都放不下时，创建新的内存块
+    if (!allocated)
+    {
+        MemoryBlock block{};
+        block.size = blockSize;
+        block.memory = allocateDeviceMemory(blockSize, allocation.memoryTypeIndex, &block.mapped);
+        block.freeRanges[0] = blockSize;
+        blocks.push_back(block);
+
+        myMemoryStatistics.blockCount++;
+        myMemoryStatistics.blockBytes += blockSize;
+
+        if (!allocateFromBlock(blocks.back(), memRequirements, allocation)) throw runtime_error("failed to sub-allocate memory!");
+    }
+
+    myMemoryStatistics.allocationCount++;
+    myMemoryStatistics.usedBytes += allocation.size;
+
+    return allocation;
+}
+
+void freeMemory(MemoryAllocation& allocation)
+{
+    if (allocation.memory == nullptr) return;
+
+    // 独立分配直接释放
+    if (allocation.block == nullptr)
+    {
+        freeDeviceMemory(allocation.memory);
+
+        myMemoryStatistics.dedicatedCount--;
+        myMemoryStatistics.dedicatedBytes -= allocation.size;
+
+        allocation = MemoryAllocation{};
+        return;
+    }
+
+    MemoryBlock& block = *allocation.block;
+
+    // 归还区间，并与前后相邻的空闲区间合并
+    VkDeviceSize offset = allocation.offset;
+    VkDeviceSize size = allocation.size;
+
+    auto next = block.freeRanges.lower_bound(offset);
+    if (next != block.freeRanges.begin())
+    {
+        auto before = prev(next);
+        if (before->first + before->second == offset)
+        {
+            offset = before->first;
+            size += before->second;
+            block.freeRanges.erase(before);
+        }
+    }
+    if (next != block.freeRanges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        block.freeRanges.erase(next);
+    }
+    block.freeRanges[offset] = size;
+
+    block.allocationCount--;
+
+    myMemoryStatistics.allocationCount--;
+    myMemoryStatistics.usedBytes -= allocation.size;
+
+    // 空闲的内存块只保留一个，其余归还驱动
+    if (block.allocationCount == 0)
+    {
+        for (auto& blocks : myMemoryBlocks[allocation.memoryTypeIndex])
+        {
+            if (blocks.size() < 2) continue;
+
+            for (auto it = blocks.begin(); it != blocks.end(); it++)
+            {
+                if (&*it != &block) continue;
+
+                myMemoryStatistics.blockCount--;
+                myMemoryStatistics.blockBytes -= block.size;
+
+                freeDeviceMemory(block.memory);
+                blocks.erase(it);
+                break;
+            }
+        }
+    }
+
+    allocation = MemoryAllocation{};
+}
+
+void printMemoryStatistics()
+{
+    // 输出 内存分配情况
+    cout << "Device memory: " << myDeviceMemoryCount << " / " << myMaxMemoryAllocationCount << " allocations" << endl;
+    cout << "  blocks: " << myMemoryStatistics.blockCount << " (" << myMemoryStatistics.blockBytes / 1024 << " KB), "
+         << "sub-allocations: " << myMemoryStatistics.allocationCount << " (" << myMemoryStatistics.usedBytes / 1024 << " KB used), "
+         << "dedicated: " << myMemoryStatistics.dedicatedCount << " (" << myMemoryStatistics.dedicatedBytes / 1024 << " KB)" << endl;
+}
+
+// ##############################################################
+
+void createMemoryAllocator()
+{
+    // 获取 内存类型 和 内存堆
+    vkGetPhysicalDeviceMemoryProperties(myPhysicalDevice, &myMemoryProperties);
+
+    // 获取 分配相关的硬件限制
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(myPhysicalDevice, &properties);
+
+    myBufferImageGranularity = properties.limits.bufferImageGranularity;
+    myMaxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    // 集成显卡的内存是统一的；独立显卡上 CPU 可见的显存堆超过 BAR 窗口时，说明开启了可调整大小的 BAR
+    for (uint32_t i = 0; i < myMemoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags flags = myMemoryProperties.memoryTypes[i].propertyFlags;
+        VkMemoryPropertyFlags directFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        if ((flags & directFlags) != directFlags) continue;
+
+        VkDeviceSize heapSize = myMemoryProperties.memoryHeaps[myMemoryProperties.memoryTypes[i].heapIndex].size;
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || heapSize > const_smallBarHeapSize) myDirectUploadSupported = true;
+    }
+
+    if (myDirectUploadSupported) cout << "Direct upload: device-local memory is host-visible, staging copies are skipped" << endl;
+}
+
+void destroyMemoryAllocator()
+{
+    // 释放 所有内存块
+    for (auto& typeBlocks : myMemoryBlocks)
+    {
+        for (auto& blocks : typeBlocks)
+        {
+            for (auto& block : blocks) freeDeviceMemory(block.memory);
+            blocks.clear();
+        }
+    }
+
+    myMemoryStatistics = MemoryStatistics{};
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+/// <summary>
+/// 
+///  网格文件格式 | 内存映射 | 子网格 | 包围盒
+/// 
+/// </summary>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <string>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 网格文件，不存在时使用硬编码的顶点与索引
+const char* const_meshFile = "Mesh0.mesh";
+
+const uint32_t const_meshMagic = 0x4853454D; // "MESH"
+const uint32_t const_meshVersion = 1;
+
+// 文件头，所有偏移都相对于文件开头
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t vertexStride; // 单个顶点的字节数
+    uint32_t attributeCount;
+    uint32_t indexSize; // 2 或 4 字节
+    uint32_t submeshCount;
+
+    uint64_t vertexCount;
+    uint64_t indexCount;
+
+    uint64_t attributesOffset; // MeshAttribute[attributeCount]
+    uint64_t submeshesOffset; // MeshSubmesh[submeshCount]
+    uint64_t vertexDataOffset;
+    uint64_t indexDataOffset;
+
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+// 顶点布局描述
+struct MeshAttribute
+{
+    uint32_t location;
+    uint32_t format; // VkFormat
+    uint32_t offset;
+    uint32_t reserved;
+};
+
+// 子网格：共享顶点与索引缓冲区的一段绘制
+struct MeshSubmesh
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+    uint32_t materialIndex;
+
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+// 只读映射的文件
+struct MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+// 直接指向映射内存的网格视图
+struct MeshView
+{
+    const MeshFileHeader* header = nullptr;
+    const MeshAttribute* attributes = nullptr;
+    const MeshSubmesh* submeshes = nullptr;
+    const void* vertexData = nullptr;
+    const void* indexData = nullptr;
+};
+
+MappedFile myMeshFile{};
+MeshView myMesh{};
+
+// 绘制使用的索引类型与子网格
+VkIndexType myIndexType = VK_INDEX_TYPE_UINT16;
+vector<MeshSubmesh> mySubmeshes{};
+
+// ##############################################################
+
+bool mapFile(const string& filename, MappedFile& mapped)
+{
+    // 文件不存在时返回 false
+#ifdef _WIN32
+    mapped.file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (mapped.file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(mapped.file, &fileSize);
+    mapped.size = static_cast<size_t>(fileSize.QuadPart);
+
+    mapped.mapping = CreateFileMappingA(mapped.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapped.mapping == nullptr) throw runtime_error("failed to map file!");
+
+    mapped.data = static_cast<const char*>(MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    mapped.file = open(filename.c_str(), O_RDONLY);
+    if (mapped.file < 0) return false;
+
+    struct stat fileStat;
+    fstat(mapped.file, &fileStat);
+    mapped.size = static_cast<size_t>(fileStat.st_size);
+
+    void* data = mmap(nullptr, mapped.size, PROT_READ, MAP_PRIVATE, mapped.file, 0);
+    if (data == MAP_FAILED) throw runtime_error("failed to map file!");
+
+    // 数据按顺序读取一次
+    madvise(data, mapped.size, MADV_SEQUENTIAL);
+    mapped.data = static_cast<const char*>(data);
+#endif
+
+    if (mapped.data == nullptr) throw runtime_error("failed to map file!");
+
+    return true;
+}
+
+void unmapFile(MappedFile& mapped)
+{
+    if (mapped.data == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mapped.data);
+    CloseHandle(mapped.mapping);
+    CloseHandle(mapped.file);
+#else
+    munmap(const_cast<char*>(mapped.data), mapped.size);
+    close(mapped.file);
+#endif
+
+    mapped = MappedFile{};
+}
+
+const void* getMeshSection(const MappedFile& mapped, uint64_t offset, uint64_t size, uint64_t alignment)
+{
+    // 检查 数据段在文件范围内并且满足对齐
+    if (offset % alignment != 0 || offset > mapped.size || size > mapped.size - offset) throw runtime_error("invalid mesh file section!");
+
+    return mapped.data + offset;
+}
+
+uint64_t getMeshSectionSize(uint64_t count, uint64_t elementSize)
+{
+    // 文件中的数量不可信，乘积溢出时视为无效
+    if (elementSize != 0 && count > UINT64_MAX / elementSize) throw runtime_error("invalid mesh file section size!");
+
+    return count * elementSize;
+}
+
+void validateSubmeshes(const MeshView& mesh)
+{
+    // 子网格的范围必须在索引与顶点数据之内，否则绘制会越界读取
+    const MeshFileHeader* header = mesh.header;
+
+    for (uint32_t i = 0; i < header->submeshCount; i++)
+    {
+        const MeshSubmesh& submesh = mesh.submeshes[i];
+
+        if (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > header->indexCount) throw runtime_error("mesh submesh index range out of bounds!");
+        if (submesh.vertexOffset < 0 || static_cast<uint64_t>(submesh.vertexOffset) >= header->vertexCount) throw runtime_error("mesh submesh vertex offset out of bounds!");
+    }
+}
+
+// ##############################################################
+
+void openMeshFile()
+{
+    // 映射 网格文件，不做解析，只建立指向各数据段的视图
+    if (!mapFile(const_meshFile, myMeshFile)) return;
+
+    const MeshFileHeader* header = static_cast<const MeshFileHeader*>(getMeshSection(myMeshFile, 0, sizeof(MeshFileHeader), 8));
+
+    if (header->magic != const_meshMagic) throw runtime_error("invalid mesh file!");
+    if (header->version != const_meshVersion) throw runtime_error("unsupported mesh file version!");
+    if (header->indexSize != 2 && header->indexSize != 4) throw runtime_error("invalid mesh index size!");
+
+    myMesh.header = header;
+    myMesh.attributes = static_cast<const MeshAttribute*>(getMeshSection(myMeshFile, header->attributesOffset, getMeshSectionSize(header->attributeCount, sizeof(MeshAttribute)), 4));
+    myMesh.submeshes = static_cast<const MeshSubmesh*>(getMeshSection(myMeshFile, header->submeshesOffset, getMeshSectionSize(header->submeshCount, sizeof(MeshSubmesh)), 4));
+    myMesh.vertexData = getMeshSection(myMeshFile, header->vertexDataOffset, getMeshSectionSize(header->vertexCount, header->vertexStride), 4);
+    myMesh.indexData = getMeshSection(myMeshFile, header->indexDataOffset, getMeshSectionSize(header->indexCount, header->indexSize), 4);
+
+    validateSubmeshes(myMesh);
+
+    // 子网格表很小，复制一份供绘制使用
+    myIndexType = header->indexSize == 4 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+    mySubmeshes.assign(myMesh.submeshes, myMesh.submeshes + header->submeshCount);
+    mySceneVersion++;
+
+    cout << "Mesh " << const_meshFile << ": " << header->vertexCount << " vertices, " << header->indexCount << " indices, " << header->submeshCount << " submeshes" << endl;
+}
+
+void closeMeshFile()
+{
+    // 数据已经写入暂存区或目标缓冲区，映射不再需要
+    myMesh = MeshView{};
+    unmapFile(myMeshFile);
+}
\ No newline at end of file
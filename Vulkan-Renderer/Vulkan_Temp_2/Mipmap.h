@@ -0,0 +1,193 @@
+/// <summary>
+/// 
+///  多级渐远纹理 | CPU 降采样 | sRGB 转换
+/// 
+/// </summary>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 每个线程至少处理的行数，避免小层级的线程开销
+const uint32_t const_mipRowsPerThread = 16;
+
+// 线性值 -> sRGB 查找表的精度
+const uint32_t const_linearToSrgbSize = 4096;
+
+// ##############################################################
+
+uint32_t getMipLevels(uint32_t width, uint32_t height)
+{
+    // 每一级长宽减半，直到 1x1
+    return static_cast<uint32_t>(floor(log2(max(width, height)))) + 1;
+}
+
+const float* getSrgbToLinearTable()
+{
+    // sRGB 编码的颜色需要在线性空间中求平均
+    static vector<float> table = []()
+    {
+        vector<float> values(256);
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+
+    return table.data();
+}
+
+const uint8_t* getLinearToSrgbTable()
+{
+    static vector<uint8_t> table = []()
+    {
+        vector<uint8_t> values(const_linearToSrgbSize);
+        for (uint32_t i = 0; i < const_linearToSrgbSize; i++)
+        {
+            float c = i / float(const_linearToSrgbSize - 1);
+            float s = c <= 0.0031308f ? c * 12.92f : 1.055f * pow(c, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<uint8_t>(s * 255.0f + 0.5f);
+        }
+        return values;
+    }();
+
+    return table.data();
+}
+
+void downsampleRows(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t rowBegin, uint32_t rowEnd)
+{
+    // 2x2 盒式滤波，奇数尺寸时复制边缘像素
+    const float* toLinear = getSrgbToLinearTable();
+    const uint8_t* toSrgb = getLinearToSrgbTable();
+
+    const float scale = float(const_linearToSrgbSize - 1);
+
+#ifdef USE_SSE2
+    const __m128 quarterScale = _mm_set1_ps(0.25f * scale);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi32(2);
+
+    // 每次 4 个输出像素，每行读取 8 个源像素，不需要复制边缘的部分
+    uint32_t vectorWidth = min(dstWidth, srcWidth / 2) & ~3u;
+#endif
+
+    for (uint32_t y = rowBegin; y < rowEnd; y++)
+    {
+        const uint8_t* row0 = src + static_cast<size_t>(min(2 * y, srcHeight - 1)) * srcWidth * 4;
+        const uint8_t* row1 = src + static_cast<size_t>(min(2 * y + 1, srcHeight - 1)) * srcWidth * 4;
+        uint8_t* out = dst + static_cast<size_t>(y) * dstWidth * 4;
+
+        uint32_t x = 0;
+
+#ifdef USE_SSE2
+        for (; x < vectorWidth; x += 4)
+        {
+            const uint8_t* p0 = row0 + x * 8;
+            const uint8_t* p1 = row1 + x * 8;
+
+            // 透明度：取每个像素的最高字节，相邻两个像素相加，再加上另一行
+            __m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0));
+            __m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + 16));
+            __m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1));
+            __m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + 16));
+
+            __m128i alphaTop = _mm_madd_epi16(_mm_packs_epi32(_mm_srli_epi32(top0, 24), _mm_srli_epi32(top1, 24)), ones);
+            __m128i alphaBottom = _mm_madd_epi16(_mm_packs_epi32(_mm_srli_epi32(bottom0, 24), _mm_srli_epi32(bottom1, 24)), ones);
+
+            alignas(16) uint32_t result[4][4]; // 每个通道 4 个输出像素
+            _mm_store_si128(reinterpret_cast<__m128i*>(result[3]), _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(alphaTop, alphaBottom), two), 2));
+
+            // 颜色：查表转换到线性空间，每个向量是 4 个输出像素的同一通道，相加顺序与逐像素的实现相同
+            for (int c = 0; c < 3; c++)
+            {
+                __m128 left0 = _mm_set_ps(toLinear[p0[24 + c]], toLinear[p0[16 + c]], toLinear[p0[8 + c]], toLinear[p0[c]]);
+                __m128 right0 = _mm_set_ps(toLinear[p0[28 + c]], toLinear[p0[20 + c]], toLinear[p0[12 + c]], toLinear[p0[4 + c]]);
+                __m128 left1 = _mm_set_ps(toLinear[p1[24 + c]], toLinear[p1[16 + c]], toLinear[p1[8 + c]], toLinear[p1[c]]);
+                __m128 right1 = _mm_set_ps(toLinear[p1[28 + c]], toLinear[p1[20 + c]], toLinear[p1[12 + c]], toLinear[p1[4 + c]]);
+
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(left0, right0), left1), right1);
+                _mm_store_si128(reinterpret_cast<__m128i*>(result[c]), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, quarterScale), half)));
+            }
+
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                out[(x + i) * 4 + 0] = toSrgb[result[0][i]];
+                out[(x + i) * 4 + 1] = toSrgb[result[1][i]];
+                out[(x + i) * 4 + 2] = toSrgb[result[2][i]];
+                out[(x + i) * 4 + 3] = static_cast<uint8_t>(result[3][i]);
+            }
+        }
+#endif
+
+        // 剩余的像素与右侧边缘逐个处理
+        for (; x < dstWidth; x++)
+        {
+            uint32_t x0 = min(2 * x, srcWidth - 1) * 4;
+            uint32_t x1 = min(2 * x + 1, srcWidth - 1) * 4;
+
+            const uint8_t* p[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+
+            for (int c = 0; c < 3; c++)
+            {
+                float average = (toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]]) * 0.25f;
+                out[x * 4 + c] = toSrgb[static_cast<uint32_t>(average * scale + 0.5f)];
+            }
+
+            // 透明度本身就是线性的
+            out[x * 4 + 3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+        }
+    }
+}
+
+void downsampleImage(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+    // 按行划分给多个线程
+    uint32_t threadCount = max(1u, min(thread::hardware_concurrency(), dstHeight / const_mipRowsPerThread));
+
+    if (threadCount == 1)
+    {
+        downsampleRows(src, srcWidth, srcHeight, dst, dstWidth, 0, dstHeight);
+        return;
+    }
+
+    vector<thread> workers{};
+    uint32_t rowsPerThread = (dstHeight + threadCount - 1) / threadCount;
+
+    for (uint32_t row = 0; row < dstHeight; row += rowsPerThread)
+    {
+        workers.emplace_back(downsampleRows, src, srcWidth, srcHeight, dst, dstWidth, row, min(row + rowsPerThread, dstHeight));
+    }
+
+    for (auto& worker : workers) worker.join();
+}
+
+vector<vector<uint8_t>> buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+    // 生成第 1 级及之后的所有层级（RGBA8 sRGB），第 0 级直接使用原图
+    vector<vector<uint8_t>> levels(mipLevels > 0 ? mipLevels - 1 : 0);
+
+    const uint8_t* src = pixels;
+    uint32_t srcWidth = width;
+    uint32_t srcHeight = height;
+
+    for (uint32_t i = 1; i < mipLevels; i++)
+    {
+        uint32_t dstWidth = max(srcWidth / 2, 1u);
+        uint32_t dstHeight = max(srcHeight / 2, 1u);
+
+        levels[i - 1].resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+        downsampleImage(src, srcWidth, srcHeight, levels[i - 1].data(), dstWidth, dstHeight);
+
+        src = levels[i - 1].data();
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+    }
+
+    return levels;
+}
\ No newline at end of file
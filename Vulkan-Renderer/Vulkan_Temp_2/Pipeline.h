@@ -0,0 +1,471 @@
+/// <summary>
+/// 
+///  管线描述 | 状态哈希 | 管线对象缓存
+/// 
+/// </summary>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+enum BlendMode
+{
+    BLEND_MODE_OPAQUE,
+    BLEND_MODE_ALPHA, // 按源透明度混合
+    BLEND_MODE_ADDITIVE // 颜色相加
+};
+
+// 着色器中的特化常量，与 shader.vert / shader.frag 中的 constant_id 一致
+enum ShaderConstant : uint32_t
+{
+    SHADER_CONSTANT_UV_SCALE = 0, // float，纹理坐标缩放
+    SHADER_CONSTANT_USE_TEXTURE = 1, // bool，是否采样纹理
+    SHADER_CONSTANT_USE_VERTEX_COLOR = 2, // bool，是否乘以顶点颜色
+    SHADER_CONSTANT_USE_MODEL_MATRIX = 3 // bool，是否应用模型矩阵
+};
+
+// 单个特化常量，值按 4 字节保存
+struct SpecializationConstant
+{
+    uint32_t constantID;
+    uint32_t value;
+};
+
+// 创建一条图形管线需要的全部状态
+struct PipelineDescription
+{
+    // 内嵌的着色器 (见 Shaders.h)
+    ShaderCode vertexShader{};
+    ShaderCode fragmentShader{};
+
+    // 着色器变体，按 id 排序，未设置的常量使用着色器中的默认值
+    vector<SpecializationConstant> constants{};
+
+    // 顶点布局
+    VkVertexInputBindingDescription vertexBinding{};
+    vector<VkVertexInputAttributeDescription> vertexAttributes{};
+
+    // 固定功能状态
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    BlendMode blendMode = BLEND_MODE_OPAQUE;
+
+    bool depthTest = false;
+    bool depthWrite = false;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS;
+
+    // 渲染通道兼容性：附件格式与采样数相同的渲染通道可以共用管线
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    uint32_t subpass = 0;
+
+    // 创建时使用的对象，句柄每次运行都不同，不参与哈希（renderPass 只有是否为空参与）
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE; // 为空时用于动态渲染
+};
+
+bool operator==(const PipelineDescription& a, const PipelineDescription& b)
+{
+    // 兼容的渲染通道视为相同，只比较是否使用渲染通道
+    return a.vertexShader.code == b.vertexShader.code && a.fragmentShader.code == b.fragmentShader.code &&
+        a.constants.size() == b.constants.size() &&
+        (a.constants.empty() || memcmp(a.constants.data(), b.constants.data(), a.constants.size() * sizeof(SpecializationConstant)) == 0) &&
+        memcmp(&a.vertexBinding, &b.vertexBinding, sizeof(a.vertexBinding)) == 0 &&
+        a.vertexAttributes.size() == b.vertexAttributes.size() &&
+        (a.vertexAttributes.empty() || memcmp(a.vertexAttributes.data(), b.vertexAttributes.data(), a.vertexAttributes.size() * sizeof(VkVertexInputAttributeDescription)) == 0) &&
+        a.topology == b.topology && a.polygonMode == b.polygonMode && a.cullMode == b.cullMode && a.frontFace == b.frontFace && a.blendMode == b.blendMode &&
+        a.depthTest == b.depthTest && a.depthWrite == b.depthWrite && a.depthCompare == b.depthCompare &&
+        a.colorFormat == b.colorFormat && a.depthFormat == b.depthFormat && a.samples == b.samples && a.subpass == b.subpass &&
+        (a.renderPass == VK_NULL_HANDLE) == (b.renderPass == VK_NULL_HANDLE) && a.layout == b.layout;
+}
+
+uint64_t hashPipelineDescription(const PipelineDescription& description)
+{
+    // 只对描述的内容求哈希，不同次运行结果相同
+    auto hashValue = [](uint64_t hash, uint32_t value) { return hashBytes(&value, sizeof(value), hash); };
+
+    // 着色器内容的哈希已经预先计算
+    uint64_t hash = hashBytes(&description.vertexShader.hash, sizeof(uint64_t));
+    hash = hashBytes(&description.fragmentShader.hash, sizeof(uint64_t), hash);
+
+    for (const auto& constant : description.constants)
+    {
+        hash = hashValue(hash, constant.constantID);
+        hash = hashValue(hash, constant.value);
+    }
+
+    hash = hashValue(hash, description.vertexBinding.binding);
+    hash = hashValue(hash, description.vertexBinding.stride);
+    hash = hashValue(hash, description.vertexBinding.inputRate);
+
+    for (const auto& attribute : description.vertexAttributes)
+    {
+        hash = hashValue(hash, attribute.location);
+        hash = hashValue(hash, attribute.binding);
+        hash = hashValue(hash, attribute.format);
+        hash = hashValue(hash, attribute.offset);
+    }
+
+    hash = hashValue(hash, description.topology);
+    hash = hashValue(hash, description.polygonMode);
+    hash = hashValue(hash, description.cullMode);
+    hash = hashValue(hash, description.frontFace);
+    hash = hashValue(hash, description.blendMode);
+
+    hash = hashValue(hash, description.depthTest);
+    hash = hashValue(hash, description.depthWrite);
+    hash = hashValue(hash, description.depthCompare);
+
+    hash = hashValue(hash, description.colorFormat);
+    hash = hashValue(hash, description.depthFormat);
+    hash = hashValue(hash, description.samples);
+    hash = hashValue(hash, description.subpass);
+    hash = hashValue(hash, description.renderPass == VK_NULL_HANDLE); // 动态渲染与渲染通道的管线不能互换
+
+    return hash;
+}
+
+void setShaderConstant(PipelineDescription& description, uint32_t constantID, uint32_t value)
+{
+    // 按 id 有序插入，已存在时覆盖
+    auto position = description.constants.begin();
+    while (position != description.constants.end() && position->constantID < constantID) position++;
+
+    if (position != description.constants.end() && position->constantID == constantID) position->value = value;
+    else description.constants.insert(position, SpecializationConstant{ constantID, value });
+}
+
+void setShaderConstant(PipelineDescription& description, uint32_t constantID, int32_t value)
+{
+    setShaderConstant(description, constantID, static_cast<uint32_t>(value));
+}
+
+void setShaderConstant(PipelineDescription& description, uint32_t constantID, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    setShaderConstant(description, constantID, bits);
+}
+
+void setShaderConstant(PipelineDescription& description, uint32_t constantID, bool value)
+{
+    // 着色器中的 bool 常量按 VkBool32 读取
+    setShaderConstant(description, constantID, static_cast<uint32_t>(value ? VK_TRUE : VK_FALSE));
+}
+
+struct PipelineDescriptionHash
+{
+    size_t operator()(const PipelineDescription& description) const { return static_cast<size_t>(hashPipelineDescription(description)); }
+};
+
+// 每种状态组合只创建一次
+unordered_map<PipelineDescription, VkPipeline, PipelineDescriptionHash> myPipelines{};
+
+// 等待并行编译的管线描述
+vector<PipelineDescription> myPipelineQueue{};
+
+// ##############################################################
+
+VkShaderModule createShaderModule(const ShaderCode& shader)
+{
+    // 直接使用内嵌的 SPIR-V
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = shader.size;
+    createInfo.pCode = shader.code;
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(myDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        throw runtime_error("failed to create shader module!");
+    }
+
+    return shaderModule;
+}
+
+VkPipeline createPipeline(const PipelineDescription& description, VkPipelineCache pipelineCache)
+{
+    // 设置 着色器模块
+    VkShaderModule vertShaderModule = createShaderModule(description.vertexShader);
+    VkShaderModule fragShaderModule = createShaderModule(description.fragmentShader);
+
+    // 设置 着色器阶段
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = vertShaderModule;
+    vertShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module = fragShaderModule;
+    fragShaderStageInfo.pName = "main";
+
+    // 设置 特化常量，两个阶段共用，阶段中不存在的 id 被忽略
+    vector<VkSpecializationMapEntry> mapEntries(description.constants.size());
+    vector<uint32_t> constantData(description.constants.size());
+
+    for (size_t i = 0; i < description.constants.size(); i++)
+    {
+        mapEntries[i].constantID = description.constants[i].constantID;
+        mapEntries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+        mapEntries[i].size = sizeof(uint32_t);
+        constantData[i] = description.constants[i].value;
+    }
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+    specializationInfo.pMapEntries = mapEntries.data();
+    specializationInfo.dataSize = constantData.size() * sizeof(uint32_t);
+    specializationInfo.pData = constantData.data();
+
+    if (!description.constants.empty())
+    {
+        vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
+        fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+    }
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+    // 设置 顶点输入
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+    vertexInputInfo.pVertexBindingDescriptions = &description.vertexBinding;
+    vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+    // 设置 图元输入
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = description.topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // 设置 视口状态
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    // 设置 光栅化器
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = description.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = description.cullMode;
+    rasterizer.frontFace = description.frontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    // 设置 多重采样
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = description.samples;
+
+    // 设置 深度测试，没有深度附件时被忽略
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = description.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = description.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = description.depthCompare;
+
+    // 设置 混合方式
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = description.blendMode == BLEND_MODE_OPAQUE ? VK_FALSE : VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment.dstColorBlendFactor = description.blendMode == BLEND_MODE_ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    // 设置 混合参数
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f;
+    colorBlending.blendConstants[1] = 0.0f;
+    colorBlending.blendConstants[2] = 0.0f;
+    colorBlending.blendConstants[3] = 0.0f;
+
+    // 设置 动态状态
+    vector<VkDynamicState> dynamicStates =
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    // 创建 渲染管线
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = description.layout;
+    pipelineInfo.renderPass = description.renderPass;
+    pipelineInfo.subpass = description.subpass;
+
+    // 没有渲染通道时通过动态渲染使用，附件格式直接写在管线中
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &description.colorFormat;
+    renderingInfo.depthAttachmentFormat = description.depthFormat;
+
+    if (description.renderPass == VK_NULL_HANDLE)
+    {
+        pipelineInfo.pNext = &renderingInfo;
+        pipelineInfo.subpass = 0;
+    }
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    // 通过管线缓存创建，热启动时跳过着色器编译
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(myDevice, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    // 销毁 着色器模块
+    vkDestroyShaderModule(myDevice, fragShaderModule, nullptr);
+    vkDestroyShaderModule(myDevice, vertShaderModule, nullptr);
+
+    if (result != VK_SUCCESS) throw runtime_error("failed to create graphics pipeline!");
+
+    return pipeline;
+}
+
+VkPipeline getPipeline(const PipelineDescription& description)
+{
+    // 相同状态返回已有的管线，否则创建并记录
+    auto found = myPipelines.find(description);
+    if (found != myPipelines.end()) return found->second;
+
+    auto start = chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = createPipeline(description, myPipelineCache);
+    myPipelines.emplace(description, pipeline);
+
+    myPipelineCreateMs += elapsedMs(start);
+
+    return pipeline;
+}
+
+void queuePipeline(const PipelineDescription& description)
+{
+    // 加入编译队列，已经存在或已排队的描述跳过
+    if (myPipelines.count(description) != 0) return;
+
+    for (const auto& queued : myPipelineQueue)
+    {
+        if (queued == description) return;
+    }
+
+    myPipelineQueue.push_back(description);
+}
+
+void compilePipelineRange(const vector<PipelineDescription>* queue, vector<VkPipeline>* pipelines, atomic<size_t>* next, atomic<bool>* failed, VkPipelineCache pipelineCache)
+{
+    // 每次领取一个描述，编译时间不同的管线也能均匀分配
+    for (size_t i = (*next)++; i < queue->size() && !*failed; i = (*next)++)
+    {
+        try
+        {
+            (*pipelines)[i] = createPipeline((*queue)[i], pipelineCache);
+        }
+        catch (const exception&)
+        {
+            *failed = true;
+        }
+    }
+}
+
+void compileQueuedPipelines()
+{
+    // 并行编译 队列中的管线，每个线程使用自己的缓存，最后合并到主缓存
+    if (myPipelineQueue.empty()) return;
+
+    auto start = chrono::high_resolution_clock::now();
+
+    uint32_t threadCount = max(1u, min(thread::hardware_concurrency(), static_cast<uint32_t>(myPipelineQueue.size())));
+
+    // 线程缓存以主缓存的内容初始化，热启动时同样命中
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(myDevice, myPipelineCache, &dataSize, nullptr);
+
+    vector<char> data(dataSize);
+    if (dataSize > 0) vkGetPipelineCacheData(myDevice, myPipelineCache, &dataSize, data.data());
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = dataSize;
+    cacheInfo.pInitialData = dataSize > 0 ? data.data() : nullptr;
+
+    vector<VkPipelineCache> threadCaches(threadCount);
+    for (auto& threadCache : threadCaches)
+    {
+        if (vkCreatePipelineCache(myDevice, &cacheInfo, nullptr, &threadCache) != VK_SUCCESS) throw runtime_error("failed to create pipeline cache!");
+    }
+
+    vector<VkPipeline> pipelines(myPipelineQueue.size(), VK_NULL_HANDLE);
+    atomic<size_t> next{ 0 };
+    atomic<bool> failed{ false };
+
+    vector<thread> workers{};
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(compilePipelineRange, &myPipelineQueue, &pipelines, &next, &failed, threadCaches[i]);
+    }
+
+    for (auto& worker : workers) worker.join();
+
+    // 合并 线程缓存，之后随主缓存一起写回磁盘
+    vkMergePipelineCaches(myDevice, myPipelineCache, threadCount, threadCaches.data());
+    for (auto& threadCache : threadCaches) vkDestroyPipelineCache(myDevice, threadCache, nullptr);
+
+    // 记录 编译结果，失败时也要保存已创建的管线以便销毁
+    for (size_t i = 0; i < pipelines.size(); i++)
+    {
+        if (pipelines[i] != VK_NULL_HANDLE) myPipelines.emplace(myPipelineQueue[i], pipelines[i]);
+    }
+
+    size_t pipelineCount = myPipelineQueue.size();
+    myPipelineQueue.clear();
+
+    if (failed) throw runtime_error("failed to create graphics pipeline!");
+
+    double compileMs = elapsedMs(start);
+    myPipelineCreateMs += compileMs;
+
+    cout << "Pipelines: " << pipelineCount << " compiled on " << threadCount << " threads in " << compileMs << " ms" << endl;
+}
+
+void destroyPipelines()
+{
+    for (auto& pipeline : myPipelines) vkDestroyPipeline(myDevice, pipeline.second, nullptr);
+    myPipelines.clear();
+}
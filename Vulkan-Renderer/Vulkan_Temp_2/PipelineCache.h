@@ -0,0 +1,193 @@
+/// <summary>
+/// 
+///  管线缓存 | 磁盘持久化 | 启动计时
+/// 
+/// </summary>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 管线缓存文件，写入时先写临时文件再替换
+const char* const_pipelineCacheFile = "pipeline.cache";
+const char* const_pipelineCacheTempFile = "pipeline.cache.tmp";
+
+// 超过上限的缓存不读取也不写入
+const size_t const_pipelineCacheMaxSize = 32ull * 1024 * 1024;
+
+const uint32_t const_pipelineCacheMagic = 0x43504B56; // "VKPC"
+const uint32_t const_pipelineCacheVersion = 1;
+
+// 文件头，驱动或设备变化后缓存失效
+struct PipelineCacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+
+    uint64_t dataSize;
+    uint64_t checksum; // 数据的 FNV-1a 哈希，检测写入中断造成的损坏
+};
+
+VkPipelineCache myPipelineCache = VK_NULL_HANDLE;
+
+bool myPipelineCacheWarm = false; // 是否从文件中加载了有效缓存
+double myPipelineCreateMs = 0.0; // 创建管线的总耗时
+
+// ##############################################################
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    // FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+PipelineCacheFileHeader getPipelineCacheHeader()
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(myPhysicalDevice, &properties);
+
+    PipelineCacheFileHeader header{};
+    header.magic = const_pipelineCacheMagic;
+    header.version = const_pipelineCacheVersion;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    return header;
+}
+
+vector<char> loadPipelineCacheData()
+{
+    // 文件不存在或与当前设备不匹配时返回空数据
+    ifstream file(const_pipelineCacheFile, ios::ate | ios::binary);
+    if (!file.is_open()) return {};
+
+    size_t fileSize = (size_t)file.tellg();
+    if (fileSize < sizeof(PipelineCacheFileHeader) || fileSize > sizeof(PipelineCacheFileHeader) + const_pipelineCacheMaxSize) return {};
+
+    PipelineCacheFileHeader header{};
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    PipelineCacheFileHeader expected = getPipelineCacheHeader();
+
+    if (header.magic != expected.magic || header.version != expected.version) return {};
+    if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID || header.driverVersion != expected.driverVersion) return {};
+    if (memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) return {};
+    if (header.dataSize != fileSize - sizeof(PipelineCacheFileHeader)) return {};
+
+    vector<char> data((size_t)header.dataSize);
+    file.read(data.data(), data.size());
+
+    if (!file || hashBytes(data.data(), data.size()) != header.checksum) return {};
+
+    return data;
+}
+
+bool replaceFile(const char* source, const char* destination)
+{
+    // 替换是原子的，读取方只会看到旧文件或完整的新文件
+#ifdef _WIN32
+    return MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(source, destination) == 0;
+#endif
+}
+
+void savePipelineCache()
+{
+    // 写回 管线缓存，失败时保留原文件
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(myDevice, myPipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) return;
+
+    if (dataSize > const_pipelineCacheMaxSize)
+    {
+        cout << "Pipeline cache: " << dataSize << " bytes exceeds limit, not saved" << endl;
+        return;
+    }
+
+    vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(myDevice, myPipelineCache, &dataSize, data.data()) != VK_SUCCESS) return;
+
+    PipelineCacheFileHeader header = getPipelineCacheHeader();
+    header.dataSize = dataSize;
+    header.checksum = hashBytes(data.data(), dataSize);
+
+    {
+        ofstream file(const_pipelineCacheTempFile, ios::binary | ios::trunc);
+        if (!file.is_open()) return;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), dataSize);
+        file.flush();
+
+        if (!file)
+        {
+            file.close();
+            remove(const_pipelineCacheTempFile);
+            return;
+        }
+    }
+
+    if (!replaceFile(const_pipelineCacheTempFile, const_pipelineCacheFile)) remove(const_pipelineCacheTempFile);
+}
+
+void printStartupTime(double startupMs)
+{
+    // 输出 冷启动 / 热启动耗时
+    cout << "Startup: " << startupMs << " ms, pipelines " << myPipelineCreateMs << " ms (" << (myPipelineCacheWarm ? "warm" : "cold") << " pipeline cache)" << endl;
+}
+
+// ##############################################################
+
+void createPipelineCache()
+{
+    // 读取 上次运行保存的缓存，无效时从空缓存开始
+    vector<char> data = loadPipelineCacheData();
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    // 驱动仍可能拒绝数据，此时重新创建空缓存
+    if (vkCreatePipelineCache(myDevice, &cacheInfo, nullptr, &myPipelineCache) != VK_SUCCESS)
+    {
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        data.clear();
+
+        if (vkCreatePipelineCache(myDevice, &cacheInfo, nullptr, &myPipelineCache) != VK_SUCCESS) throw runtime_error("failed to create pipeline cache!");
+    }
+
+    myPipelineCacheWarm = !data.empty();
+
+    cout << "Pipeline cache " << const_pipelineCacheFile << ": " << (myPipelineCacheWarm ? "loaded " + to_string(data.size()) + " bytes" : string("cold start")) << endl;
+}
+
+void destroyPipelineCache()
+{
+    savePipelineCache();
+
+    vkDestroyPipelineCache(myDevice, myPipelineCache, nullptr);
+    myPipelineCache = VK_NULL_HANDLE;
+}
@@ -0,0 +1,400 @@
+/// <summary>
+/// 
+///  绘制列表 | 多线程录制 | 次级命令缓冲区 | 每帧命令池 | 命令缓冲区复用
+/// 
+/// </summary>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 每个线程至少录制的绘制数量，绘制较少时在主线程上直接录制到主命令缓冲区
+const uint32_t const_drawsPerRecordThread = 512;
+
+// 一次绘制，由物体与子网格展开得到
+struct DrawItem
+{
+    uint32_t transformIndex; // myObjectTransforms 中的下标
+    uint32_t materialIndex; // 写入推送常量的值
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+};
+
+vector<DrawItem> myDrawList{};
+
+// 每帧每个线程一个命令池与一个次级命令缓冲区，0 号为主线程
+vector<vector<VkCommandPool>> myRecordCommandPools{};
+vector<vector<VkCommandBuffer>> mySecondaryCommandBuffers{};
+
+mutex myRecordMutex;
+condition_variable myRecordRequested;
+condition_variable myRecordFinished;
+
+// 当前录制任务，由主线程在唤醒工作线程前写入
+uint64_t myRecordGeneration = 0;
+uint32_t myRecordThreadCount = 0;
+uint32_t myRecordPending = 0;
+uint32_t myRecordFrame = 0;
+uint32_t myRecordImageIndex = 0;
+bool myRecordStopping = false;
+exception_ptr myRecordError = nullptr; // 工作线程录制失败时的异常，由主线程重新抛出
+
+WorkerThreads myRecordWorkers{};
+
+// 复用的主命令缓冲区，记录录制时依赖的状态
+struct CachedCommandBuffer
+{
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    bool recorded = false;
+    uint64_t sceneVersion = 0;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    uint32_t uniformOffset = 0;
+};
+
+// 每帧一个命令池，命令缓冲区单独重置，不随帧重置
+vector<VkCommandPool> myCachedCommandPools{};
+
+// 每帧每张交换链图像一个，等待这一帧的时间线后即可重新录制
+vector<vector<CachedCommandBuffer>> myCachedCommandBuffers{};
+
+// 场景版本连续不变至少一帧后才录制缓存的命令缓冲区，之前按每帧的方式录制
+uint64_t myObservedSceneVersion = UINT64_MAX;
+uint32_t myStableSceneFrames = 0;
+
+uint32_t myCommandBufferRecordCount = 0; // 录制缓存的命令缓冲区的次数
+uint32_t myCommandBufferReuseCount = 0;
+uint32_t myCommandBufferTransientCount = 0; // 场景变化时每帧录制的次数
+
+// ##############################################################
+
+void buildDrawList()
+{
+    // 每个物体的每个子网格一次绘制
+    myDrawList.clear();
+    myDrawList.reserve(myObjectTransforms.size() * mySubmeshes.size());
+
+    for (uint32_t transformIndex = 0; transformIndex < myObjectTransforms.size(); transformIndex++)
+    {
+        for (const auto& submesh : mySubmeshes)
+        {
+            DrawItem draw{};
+            draw.transformIndex = transformIndex;
+            draw.materialIndex = submesh.materialIndex;
+            draw.indexCount = submesh.indexCount;
+            draw.firstIndex = submesh.firstIndex;
+            draw.vertexOffset = submesh.vertexOffset;
+            myDrawList.push_back(draw);
+        }
+    }
+}
+
+void recordDraws(VkCommandBuffer commandBuffer, uint32_t frame, size_t begin, size_t end)
+{
+    // 次级命令缓冲区不继承状态，每个都完整设置一次
+
+    // 绑定 渲染管线
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myGraphicsPipeline);
+
+    // 设置 渲染视口
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)mySwapChainExtent.width;
+    viewport.height = (float)mySwapChainExtent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    // 设置 裁剪矩阵
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = mySwapChainExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    // 绑定 顶点缓冲区
+    VkBuffer vertexBuffers[] = { myVertexBuffer };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+    // 绑定 索引缓冲区
+    vkCmdBindIndexBuffer(commandBuffer, myIndexBuffer, 0, myIndexType);
+
+    // 绑定 描述集，整帧共用观察与投影矩阵
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myPipelineLayout, 0, 1, &descriptorSets[frame], 1, &myFrameUniformOffset);
+
+    // 模型矩阵与材质通过推送常量写入命令缓冲区，只在变化时写入
+    uint32_t transformIndex = UINT32_MAX;
+    uint32_t materialIndex = UINT32_MAX;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const DrawItem& draw = myDrawList[i];
+
+        if (draw.transformIndex != transformIndex)
+        {
+            transformIndex = draw.transformIndex;
+            vkCmdPushConstants(commandBuffer, myPipelineLayout, const_pushConstantStages, offsetof(PushConstants, model), sizeof(glm::mat4), &myObjectTransforms[transformIndex]);
+        }
+
+        if (draw.materialIndex != materialIndex)
+        {
+            materialIndex = draw.materialIndex;
+            vkCmdPushConstants(commandBuffer, myPipelineLayout, const_pushConstantStages, offsetof(PushConstants, materialIndex), sizeof(uint32_t), &materialIndex);
+        }
+
+        vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, draw.vertexOffset, 0);
+    }
+}
+
+void recordSecondaryCommandBuffer(uint32_t threadIndex)
+{
+    // 绘制列表均匀分给各个线程
+    size_t drawCount = myDrawList.size();
+    size_t begin = drawCount * threadIndex / myRecordThreadCount;
+    size_t end = drawCount * (threadIndex + 1) / myRecordThreadCount;
+
+    VkCommandBuffer commandBuffer = mySecondaryCommandBuffers[myRecordFrame][threadIndex];
+
+    // 继承 主命令缓冲区中的渲染通道或动态渲染
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &mySwapChainImageFormat;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+    if (myDynamicRenderingEnabled) inheritanceInfo.pNext = &renderingInfo;
+    else
+    {
+        inheritanceInfo.renderPass = myRenderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = mySwapChainFramebuffers[myRecordImageIndex];
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw runtime_error("failed to begin recording secondary command buffer!");
+
+    recordDraws(commandBuffer, myRecordFrame, begin, end);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw runtime_error("failed to record secondary command buffer!");
+}
+
+void recordWorker(uint32_t threadIndex)
+{
+    uint64_t generation = 0;
+
+    while (true)
+    {
+        // 等待新的录制任务
+        {
+            unique_lock<mutex> lock(myRecordMutex);
+            myRecordRequested.wait(lock, [&]() { return myRecordStopping || myRecordGeneration != generation; });
+
+            if (myRecordStopping) return;
+
+            generation = myRecordGeneration;
+        }
+
+        // 本次任务不需要这么多线程时跳过，异常不能离开线程函数
+        exception_ptr error = nullptr;
+        try
+        {
+            if (threadIndex < myRecordThreadCount) recordSecondaryCommandBuffer(threadIndex);
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        {
+            lock_guard<mutex> lock(myRecordMutex);
+            if (error != nullptr && myRecordError == nullptr) myRecordError = error;
+            myRecordPending--;
+        }
+        myRecordFinished.notify_one();
+    }
+}
+
+uint32_t getRecordThreadCount()
+{
+    // 0 表示直接录制到主命令缓冲区
+    uint32_t maxThreads = static_cast<uint32_t>(myRecordWorkers.threads.size()) + 1;
+    uint32_t threadCount = static_cast<uint32_t>(myDrawList.size() / const_drawsPerRecordThread);
+
+    return threadCount < 2 ? 0 : min(threadCount, maxThreads);
+}
+
+void recordSecondaryCommandBuffers(uint32_t frame, uint32_t imageIndex, uint32_t threadCount)
+{
+    // 唤醒 工作线程
+    {
+        lock_guard<mutex> lock(myRecordMutex);
+        myRecordFrame = frame;
+        myRecordImageIndex = imageIndex;
+        myRecordThreadCount = threadCount;
+        myRecordPending = static_cast<uint32_t>(myRecordWorkers.threads.size());
+        myRecordGeneration++;
+    }
+    myRecordRequested.notify_all();
+
+    // 主线程录制第一段，失败时也要等工作线程完成，之后再抛出
+    exception_ptr error = nullptr;
+    try
+    {
+        recordSecondaryCommandBuffer(0);
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+
+    // 等待 所有工作线程完成
+    {
+        unique_lock<mutex> lock(myRecordMutex);
+        myRecordFinished.wait(lock, []() { return myRecordPending == 0; });
+
+        if (error == nullptr) error = myRecordError;
+        myRecordError = nullptr;
+    }
+
+    if (error != nullptr) rethrow_exception(error);
+}
+
+void resetFrameCommandPools(uint32_t frame)
+{
+    // 这一帧上一次提交的命令已经完成，整个命令池一起重置
+    vkResetCommandPool(myDevice, myCommandPools[frame], 0);
+
+    for (VkCommandPool commandPool : myRecordCommandPools[frame]) vkResetCommandPool(myDevice, commandPool, 0);
+}
+
+void resetCommandBufferCache()
+{
+    // 交换链重建后图像数量可能变化，释放所有缓存的命令缓冲区，使用时重新分配
+    // 调用前设备必须空闲
+    for (uint32_t frame = 0; frame < myCachedCommandBuffers.size(); frame++)
+    {
+        for (auto& cached : myCachedCommandBuffers[frame])
+        {
+            if (cached.commandBuffer != VK_NULL_HANDLE) vkFreeCommandBuffers(myDevice, myCachedCommandPools[frame], 1, &cached.commandBuffer);
+        }
+
+        myCachedCommandBuffers[frame].assign(mySwapChainImages.size(), CachedCommandBuffer{});
+    }
+}
+
+void printCommandBufferStatistics()
+{
+    // 输出 每帧命令缓冲区的来源，静态场景中几乎全部为复用
+    uint32_t frameCount = myCommandBufferRecordCount + myCommandBufferReuseCount + myCommandBufferTransientCount;
+
+    cout << "Command buffers: " << frameCount << " frames, reused " << myCommandBufferReuseCount << ", recorded for reuse " << myCommandBufferRecordCount
+         << ", recorded per frame " << myCommandBufferTransientCount << endl;
+}
+
+void stopRecordWorkers()
+{
+    // 正在进行的录制完成后退出
+    {
+        lock_guard<mutex> lock(myRecordMutex);
+        myRecordStopping = true;
+    }
+    myRecordRequested.notify_all();
+}
+
+// ##############################################################
+
+void createRecordContext()
+{
+    // 主线程之外的录制线程
+    uint32_t workerCount = max(1u, thread::hardware_concurrency()) - 1;
+    uint32_t threadCount = workerCount + 1;
+
+    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(myPhysicalDevice);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+    // 命令池不能被多个线程同时使用，每帧每个线程一个
+    myRecordCommandPools.assign(const_maxFrames, vector<VkCommandPool>(threadCount));
+    mySecondaryCommandBuffers.assign(const_maxFrames, vector<VkCommandBuffer>(threadCount));
+
+    for (uint32_t frame = 0; frame < const_maxFrames; frame++)
+    {
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myRecordCommandPools[frame][i]) != VK_SUCCESS) throw runtime_error("failed to create record command pool!");
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = myRecordCommandPools[frame][i];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(myDevice, &allocInfo, &mySecondaryCommandBuffers[frame][i]) != VK_SUCCESS) throw runtime_error("failed to allocate secondary command buffers!");
+        }
+    }
+
+    myRecordStopping = false;
+    myRecordWorkers.stop = stopRecordWorkers;
+    for (uint32_t i = 0; i < workerCount; i++) myRecordWorkers.threads.emplace_back(recordWorker, i + 1);
+
+    cout << "Command recording: up to " << threadCount << " threads, " << const_drawsPerRecordThread << " draws per thread minimum" << endl;
+}
+
+void createCommandBufferCache()
+{
+    if (!const_enableCommandBufferReuse) return;
+
+    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(myPhysicalDevice);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+    myCachedCommandPools.resize(const_maxFrames);
+    for (uint32_t frame = 0; frame < const_maxFrames; frame++)
+    {
+        if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myCachedCommandPools[frame]) != VK_SUCCESS) throw runtime_error("failed to create cached command pool!");
+    }
+
+    myCachedCommandBuffers.resize(const_maxFrames);
+    resetCommandBufferCache();
+}
+
+void destroyCommandBufferCache()
+{
+    // 命令缓冲区随命令池一起释放
+    for (VkCommandPool commandPool : myCachedCommandPools) vkDestroyCommandPool(myDevice, commandPool, nullptr);
+
+    myCachedCommandPools.clear();
+    myCachedCommandBuffers.clear();
+}
+
+void destroyRecordContext()
+{
+    myRecordWorkers.join();
+
+    // 命令缓冲区随命令池一起释放
+    for (auto& framePools : myRecordCommandPools)
+    {
+        for (VkCommandPool commandPool : framePools) vkDestroyCommandPool(myDevice, commandPool, nullptr);
+    }
+    myRecordCommandPools.clear();
+    mySecondaryCommandBuffers.clear();
+}
@@ -0,0 +1,491 @@
+/// <summary>
+/// 
+///  渲染图 | 资源用途 | 自动屏障 | 子资源布局跟踪
+/// 
+/// </summary>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 通道对资源的一次使用，决定同步的阶段、访问类型与图像布局
+enum ResourceUsage
+{
+    RESOURCE_USAGE_UNDEFINED, // 新图像，内容不保留
+    RESOURCE_USAGE_ACQUIRE, // 交换链图像：在等待获取信号量的阶段可用，内容不保留
+    RESOURCE_USAGE_PRESENT,
+    RESOURCE_USAGE_TRANSFER_SRC,
+    RESOURCE_USAGE_TRANSFER_DST,
+    RESOURCE_USAGE_COLOR_ATTACHMENT,
+    RESOURCE_USAGE_DEPTH_ATTACHMENT,
+    RESOURCE_USAGE_DEPTH_READ, // 只读深度测试，或深度预通道之后的主通道
+    RESOURCE_USAGE_SAMPLED_FRAGMENT,
+    RESOURCE_USAGE_SAMPLED_COMPUTE,
+    RESOURCE_USAGE_STORAGE_READ_COMPUTE,
+    RESOURCE_USAGE_STORAGE_WRITE_COMPUTE,
+    RESOURCE_USAGE_VERTEX_BUFFER,
+    RESOURCE_USAGE_INDEX_BUFFER,
+    RESOURCE_USAGE_UNIFORM_BUFFER,
+    RESOURCE_USAGE_INDIRECT_BUFFER
+};
+
+struct ResourceUsageInfo
+{
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2 access;
+    VkImageLayout layout; // 缓冲区忽略
+    bool write;
+};
+
+// 与 ResourceUsage 的顺序一致，使用同步2 的细分阶段与访问类型
+const ResourceUsageInfo const_resourceUsages[] =
+{
+    { VK_PIPELINE_STAGE_2_NONE, 0, VK_IMAGE_LAYOUT_UNDEFINED, false },
+    { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, true },
+    { VK_PIPELINE_STAGE_2_NONE, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false },
+    { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false },
+    { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true },
+    { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true },
+    { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true },
+    { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false },
+    { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+    { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+    { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false },
+    { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true },
+    { VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+    { VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+    { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+    { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false }
+};
+
+// 每个子资源（图像的每个层级与数组层，或整个缓冲区）的同步状态
+struct SubresourceState
+{
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 writeStages = 0; // 最后一次写入（包括布局转换）
+    VkAccessFlags2 writeAccess = 0;
+    VkPipelineStageFlags2 readStages = 0; // 写入之后已经同步过的读取
+    VkAccessFlags2 readAccess = 0;
+};
+
+// 外部创建的资源，每帧导入渲染图
+struct GraphResource
+{
+    string name;
+    VkImage image = VK_NULL_HANDLE; // 图像与缓冲区二选一
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkImageAspectFlags aspectMask = 0;
+    uint32_t mipLevels = 1;
+    uint32_t arrayLayers = 1;
+
+    vector<SubresourceState> states{}; // 下标为 mipLevel * arrayLayers + arrayLayer
+    bool exported = false; // 渲染图结束后需要处于 finalUsage
+    ResourceUsage finalUsage = RESOURCE_USAGE_UNDEFINED;
+};
+
+struct PassAccess
+{
+    uint32_t resource;
+    ResourceUsage usage;
+    uint32_t baseMipLevel;
+    uint32_t levelCount;
+    uint32_t baseArrayLayer;
+    uint32_t layerCount;
+};
+
+struct GraphPass
+{
+    string name;
+    function<void(VkCommandBuffer)> execute;
+    vector<PassAccess> accesses{};
+    bool sideEffect = false; // 结果不通过导出资源体现时也不能剔除
+    bool culled = false;
+    uint32_t level = 0; // 依赖深度，同一深度的通道互不依赖
+};
+
+// 同一深度的通道之前记录一次合并的屏障，每个图像屏障保留自己的阶段
+struct BarrierBatch
+{
+    BarrierBatcher barriers{}; // 所有缓冲区合并为一个全局内存屏障
+    vector<uint32_t> passes{};
+};
+
+struct RenderGraph
+{
+    vector<GraphResource> resources{};
+    vector<GraphPass> passes{};
+    vector<BarrierBatch> batches{}; // 最后一个只包含导出资源的转换
+};
+
+// 每次录制主命令缓冲区时重建，复用容器的容量
+RenderGraph myRenderGraph{};
+
+// ##############################################################
+
+ResourceUsage getLayoutUsage(VkImageLayout layout)
+{
+    // 只知道布局时使用该布局最常见的用途
+    switch (layout)
+    {
+    case VK_IMAGE_LAYOUT_UNDEFINED: return RESOURCE_USAGE_UNDEFINED;
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return RESOURCE_USAGE_PRESENT;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return RESOURCE_USAGE_TRANSFER_SRC;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return RESOURCE_USAGE_TRANSFER_DST;
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return RESOURCE_USAGE_COLOR_ATTACHMENT;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return RESOURCE_USAGE_DEPTH_ATTACHMENT;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: return RESOURCE_USAGE_DEPTH_READ;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return RESOURCE_USAGE_SAMPLED_FRAGMENT;
+    case VK_IMAGE_LAYOUT_GENERAL: return RESOURCE_USAGE_STORAGE_WRITE_COMPUTE;
+    default: throw invalid_argument("unsupported image layout!");
+    }
+}
+
+SubresourceState getInitialState(ResourceUsage usage)
+{
+    // 导入前的使用视为已经同步过的读取，或尚未同步的写入
+    const ResourceUsageInfo& info = const_resourceUsages[usage];
+
+    SubresourceState state{};
+    state.layout = info.layout;
+
+    if (info.write)
+    {
+        state.writeStages = info.stage;
+        state.writeAccess = info.access;
+    }
+    else
+    {
+        state.readStages = info.stage;
+        state.readAccess = info.access;
+    }
+
+    return state;
+}
+
+void resetRenderGraph(RenderGraph& graph)
+{
+    graph.resources.clear();
+    graph.passes.clear();
+    graph.batches.clear();
+}
+
+uint32_t importImage(RenderGraph& graph, const char* name, VkImage image, VkImageAspectFlags aspectMask, uint32_t mipLevels, uint32_t arrayLayers, ResourceUsage initialUsage)
+{
+    GraphResource resource{};
+    resource.name = name;
+    resource.image = image;
+    resource.aspectMask = aspectMask;
+    resource.mipLevels = mipLevels;
+    resource.arrayLayers = arrayLayers;
+    resource.states.assign(mipLevels * arrayLayers, getInitialState(initialUsage));
+
+    graph.resources.push_back(resource);
+    return static_cast<uint32_t>(graph.resources.size() - 1);
+}
+
+uint32_t importBuffer(RenderGraph& graph, const char* name, VkBuffer buffer, ResourceUsage initialUsage)
+{
+    GraphResource resource{};
+    resource.name = name;
+    resource.buffer = buffer;
+    resource.states.assign(1, getInitialState(initialUsage));
+
+    graph.resources.push_back(resource);
+    return static_cast<uint32_t>(graph.resources.size() - 1);
+}
+
+void exportResource(RenderGraph& graph, uint32_t resource, ResourceUsage finalUsage)
+{
+    // 导出的资源在渲染图结束时转换到最终用途，写入它的通道不会被剔除
+    graph.resources[resource].exported = true;
+    graph.resources[resource].finalUsage = finalUsage;
+}
+
+uint32_t addPass(RenderGraph& graph, const char* name, function<void(VkCommandBuffer)> execute)
+{
+    GraphPass pass{};
+    pass.name = name;
+    pass.execute = move(execute);
+
+    graph.passes.push_back(move(pass));
+    return static_cast<uint32_t>(graph.passes.size() - 1);
+}
+
+void useImage(RenderGraph& graph, uint32_t pass, uint32_t resource, ResourceUsage usage, uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS, uint32_t baseArrayLayer = 0, uint32_t layerCount = VK_REMAINING_ARRAY_LAYERS)
+{
+    const GraphResource& image = graph.resources[resource];
+
+    PassAccess access{};
+    access.resource = resource;
+    access.usage = usage;
+    access.baseMipLevel = baseMipLevel;
+    access.levelCount = levelCount == VK_REMAINING_MIP_LEVELS ? image.mipLevels - baseMipLevel : levelCount;
+    access.baseArrayLayer = baseArrayLayer;
+    access.layerCount = layerCount == VK_REMAINING_ARRAY_LAYERS ? image.arrayLayers - baseArrayLayer : layerCount;
+
+    if (access.baseMipLevel + access.levelCount > image.mipLevels || access.baseArrayLayer + access.layerCount > image.arrayLayers) throw runtime_error("render graph image access out of range!");
+
+    graph.passes[pass].accesses.push_back(access);
+}
+
+void useBuffer(RenderGraph& graph, uint32_t pass, uint32_t resource, ResourceUsage usage)
+{
+    graph.passes[pass].accesses.push_back({ resource, usage, 0, 1, 0, 1 });
+}
+
+void markSideEffect(RenderGraph& graph, uint32_t pass)
+{
+    graph.passes[pass].sideEffect = true;
+}
+
+// ##############################################################
+
+void cullPasses(RenderGraph& graph)
+{
+    // 从后往前：写入导出资源或之后仍被读取的资源的通道才需要执行
+    vector<bool> needed(graph.resources.size(), false);
+    for (size_t i = 0; i < graph.resources.size(); i++) needed[i] = graph.resources[i].exported;
+
+    for (size_t i = graph.passes.size(); i-- > 0;)
+    {
+        GraphPass& pass = graph.passes[i];
+
+        bool used = pass.sideEffect;
+        for (const auto& access : pass.accesses)
+        {
+            if (const_resourceUsages[access.usage].write && needed[access.resource]) used = true;
+        }
+
+        pass.culled = !used;
+        if (pass.culled) continue;
+
+        // 部分写入不会覆盖整个资源，写入的资源不会因此变为不需要
+        for (const auto& access : pass.accesses)
+        {
+            if (!const_resourceUsages[access.usage].write) needed[access.resource] = true;
+        }
+    }
+}
+
+void computePassLevels(RenderGraph& graph)
+{
+    // 按声明顺序推导依赖：读后写、写后写、写后读，以及图像的布局变化
+    struct ResourceHistory
+    {
+        int32_t lastWriter = -1;
+        vector<uint32_t> readers{}; // 最后一次写入之后的读取
+        VkImageLayout readLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+    vector<ResourceHistory> history(graph.resources.size());
+
+    for (uint32_t i = 0; i < graph.passes.size(); i++)
+    {
+        GraphPass& pass = graph.passes[i];
+        if (pass.culled) continue;
+
+        pass.level = 0;
+        for (const auto& access : pass.accesses)
+        {
+            const ResourceUsageInfo& info = const_resourceUsages[access.usage];
+            ResourceHistory& resource = history[access.resource];
+
+            if (resource.lastWriter >= 0) pass.level = max(pass.level, graph.passes[resource.lastWriter].level + 1);
+
+            // 不同布局的读取之间需要布局转换，与写入一样不能并列
+            bool isImage = graph.resources[access.resource].image != VK_NULL_HANDLE;
+            bool conflicts = info.write || (isImage && !resource.readers.empty() && resource.readLayout != info.layout);
+
+            if (conflicts)
+            {
+                for (uint32_t reader : resource.readers)
+                {
+                    if (reader != i) pass.level = max(pass.level, graph.passes[reader].level + 1);
+                }
+            }
+        }
+
+        // 记录 这个通道的访问，供之后的通道推导依赖
+        for (const auto& access : pass.accesses)
+        {
+            const ResourceUsageInfo& info = const_resourceUsages[access.usage];
+            ResourceHistory& resource = history[access.resource];
+
+            if (info.write || resource.readLayout != info.layout)
+            {
+                resource.readers.clear();
+                resource.readLayout = info.layout;
+            }
+
+            if (info.write) resource.lastWriter = static_cast<int32_t>(i);
+            else resource.readers.push_back(i);
+        }
+    }
+}
+
+bool transitionSubresource(const GraphResource& resource, SubresourceState& state, ResourceUsage usage, VkImageMemoryBarrier2& barrier)
+{
+    // 计算 一个子资源需要的屏障，不需要时返回 false
+    const ResourceUsageInfo& info = const_resourceUsages[usage];
+    bool isImage = resource.image != VK_NULL_HANDLE;
+    bool layoutChange = isImage && state.layout != info.layout;
+
+    if (!info.write && !layoutChange)
+    {
+        // 读取：这些阶段已经看到最后一次写入时不需要屏障
+        if ((state.readStages & info.stage) == info.stage && (state.readAccess & info.access) == info.access) return false;
+
+        state.readStages |= info.stage;
+        state.readAccess |= info.access;
+
+        if (state.writeStages == 0) return false;
+
+        barrier.srcStageMask = state.writeStages;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.dstStageMask = info.stage;
+        barrier.dstAccessMask = info.access;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = state.layout;
+        return true;
+    }
+
+    // 写入 或 布局转换：等待之前所有的读写，读取只需要执行依赖
+    VkPipelineStageFlags2 srcStages = state.writeStages | state.readStages;
+
+    // 没有之前的访问也不需要布局转换时，只记录这次写入
+    if (!layoutChange && state.writeAccess == 0 && srcStages == 0)
+    {
+        state.writeStages = info.stage;
+        state.writeAccess = info.access;
+        state.readStages = 0;
+        state.readAccess = 0;
+        return false;
+    }
+
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = state.writeAccess;
+    barrier.dstStageMask = info.stage;
+    barrier.dstAccessMask = info.access;
+    barrier.oldLayout = state.layout;
+    barrier.newLayout = isImage ? info.layout : state.layout;
+
+    // 布局转换本身相当于一次写入，之后其他阶段的读取仍需要与它同步
+    state.layout = barrier.newLayout;
+    state.writeStages = info.stage;
+    state.writeAccess = info.write ? info.access : 0;
+    state.readStages = info.write ? 0 : info.stage;
+    state.readAccess = info.write ? 0 : info.access;
+    return true;
+}
+
+void addImageBarrier(BarrierBatch& batch, const GraphResource& resource, const VkImageMemoryBarrier2& barrier, uint32_t mipLevel, uint32_t arrayLayer)
+{
+    // 与上一个屏障相邻且参数相同时合并
+    vector<VkImageMemoryBarrier2>& imageBarriers = batch.barriers.imageBarriers;
+    if (!imageBarriers.empty())
+    {
+        VkImageMemoryBarrier2& last = imageBarriers.back();
+        VkImageSubresourceRange& range = last.subresourceRange;
+
+        bool same = last.image == resource.image && last.oldLayout == barrier.oldLayout && last.newLayout == barrier.newLayout && last.srcStageMask == barrier.srcStageMask && last.dstStageMask == barrier.dstStageMask && last.srcAccessMask == barrier.srcAccessMask && last.dstAccessMask == barrier.dstAccessMask;
+
+        // 同一层级中相邻的数组层
+        if (same && range.levelCount == 1 && range.baseMipLevel == mipLevel && range.baseArrayLayer + range.layerCount == arrayLayer)
+        {
+            range.layerCount++;
+            return;
+        }
+
+        // 相邻层级的同一数组层范围
+        if (same && range.baseMipLevel + range.levelCount == mipLevel && range.baseArrayLayer == arrayLayer && range.layerCount == 1 && resource.arrayLayers == 1)
+        {
+            range.levelCount++;
+            return;
+        }
+    }
+
+    VkImageMemoryBarrier2 imageBarrier = barrier;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = resource.image;
+    imageBarrier.subresourceRange.aspectMask = resource.aspectMask;
+    imageBarrier.subresourceRange.baseMipLevel = mipLevel;
+    imageBarrier.subresourceRange.levelCount = 1;
+    imageBarrier.subresourceRange.baseArrayLayer = arrayLayer;
+    imageBarrier.subresourceRange.layerCount = 1;
+
+    queueImageBarrier(batch.barriers, imageBarrier);
+}
+
+void addAccessBarriers(BarrierBatch& batch, GraphResource& resource, ResourceUsage usage, uint32_t baseMipLevel, uint32_t levelCount, uint32_t baseArrayLayer, uint32_t layerCount)
+{
+    VkImageMemoryBarrier2 barrier{};
+
+    // 缓冲区没有布局，合并到全局内存屏障
+    if (resource.image == VK_NULL_HANDLE)
+    {
+        if (transitionSubresource(resource, resource.states[0], usage, barrier)) queueMemoryBarrier(batch.barriers, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask);
+        return;
+    }
+
+    for (uint32_t mip = baseMipLevel; mip < baseMipLevel + levelCount; mip++)
+    {
+        for (uint32_t layer = baseArrayLayer; layer < baseArrayLayer + layerCount; layer++)
+        {
+            if (transitionSubresource(resource, resource.states[mip * resource.arrayLayers + layer], usage, barrier)) addImageBarrier(batch, resource, barrier, mip, layer);
+        }
+    }
+}
+
+void compileRenderGraph(RenderGraph& graph)
+{
+    cullPasses(graph);
+    computePassLevels(graph);
+
+    // 按依赖深度排序，同一深度保持声明顺序
+    uint32_t levelCount = 0;
+    for (const auto& pass : graph.passes)
+    {
+        if (!pass.culled) levelCount = max(levelCount, pass.level + 1);
+    }
+
+    graph.batches.assign(levelCount + 1, BarrierBatch{});
+    for (uint32_t i = 0; i < graph.passes.size(); i++)
+    {
+        if (!graph.passes[i].culled) graph.batches[graph.passes[i].level].passes.push_back(i);
+    }
+
+    // 依次模拟每个深度的访问，同一深度所有通道的屏障合并为一次调用
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        BarrierBatch& batch = graph.batches[level];
+
+        for (uint32_t passIndex : batch.passes)
+        {
+            for (const auto& access : graph.passes[passIndex].accesses)
+            {
+                addAccessBarriers(batch, graph.resources[access.resource], access.usage, access.baseMipLevel, access.levelCount, access.baseArrayLayer, access.layerCount);
+            }
+        }
+    }
+
+    // 导出资源转换到最终用途
+    BarrierBatch& finalBatch = graph.batches[levelCount];
+    for (auto& resource : graph.resources)
+    {
+        if (resource.exported) addAccessBarriers(finalBatch, resource, resource.finalUsage, 0, resource.mipLevels, 0, resource.arrayLayers);
+    }
+}
+
+void executeRenderGraph(RenderGraph& graph, VkCommandBuffer commandBuffer)
+{
+    for (auto& batch : graph.batches)
+    {
+        if (hasQueuedBarriers(batch.barriers)) flushBarriers(batch.barriers, commandBuffer);
+
+        for (uint32_t passIndex : batch.passes) graph.passes[passIndex].execute(commandBuffer);
+    }
+}
@@ -0,0 +1,49 @@
+/// <summary>
+/// 
+///  内嵌着色器 | SPIR-V
+/// 
+/// </summary>
+
+#include <cstdint>
+using namespace std;
+
+// ##############################################################
+
+// 编译进程序的 SPIR-V，*.spv.inc 由 Compilation.bat 生成 (glslc -mfmt=num)
+// uint32_t 数组满足 pCode 的 4 字节对齐要求，不需要读取文件或复制
+
+constexpr uint32_t const_vertShaderCode[] =
+{
+#include "vert.spv.inc"
+};
+
+constexpr uint32_t const_fragShaderCode[] =
+{
+#include "frag.spv.inc"
+};
+
+// 着色器代码、大小（字节）及内容哈希
+struct ShaderCode
+{
+    const uint32_t* code = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0; // 编译期计算，管线查找时不再遍历代码
+};
+
+constexpr uint64_t hashShaderCode(const uint32_t* code, size_t size)
+{
+    // 按 32 位字的 FNV-1a，不同次运行结果相同
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++)
+    {
+        hash ^= code[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+#define SHADER_CODE(code) ShaderCode{ code, sizeof(code), hashShaderCode(code, sizeof(code)) }
+
+constexpr ShaderCode const_vertShader = SHADER_CODE(const_vertShaderCode);
+constexpr ShaderCode const_fragShader = SHADER_CODE(const_fragShaderCode);
@@ -0,0 +1,447 @@
+/// <summary>
+/// 
+///  暂存环形缓冲区 | 上传批次 | 完成令牌 | 队列所有权转移
+/// 
+/// </summary>
+
+#include <deque>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 暂存环形缓冲区的大小，超过该大小的上传会被拆分
+const VkDeviceSize const_stagingBufferSize = 32ull * 1024 * 1024;
+
+// 已提交的暂存区间：对应批次完成后 [start, 下一区间的 start) 即可复用
+struct StagingRegion
+{
+    uint64_t token = 0;
+    VkDeviceSize start = 0;
+};
+
+// 上传批次：一次提交中录制的所有拷贝与布局转换
+struct UploadBatch
+{
+    uint64_t token = 0; // 传输队列时间线的信号值
+    VkCommandBuffer commandBuffer = nullptr;
+    VkCommandBuffer acquireCommandBuffer = nullptr; // 图形队列上获取所有权的命令
+    uint64_t acquireValue = 0; // 获取命令在图形队列时间线上的信号值，没有获取命令时为 0
+};
+
+// 上传的数据可能被以下阶段读取
+const VkAccessFlags2 const_uploadDstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+const VkPipelineStageFlags2 const_uploadDstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+VkBuffer myStagingBuffer = nullptr;
+MemoryAllocation myStagingBufferMemory{};
+
+VkDeviceSize myStagingHead = 0; // 下一次分配的位置
+VkDeviceSize myStagingSubmitted = 0; // 已提交部分的末尾
+
+deque<StagingRegion> myStagingRegions{};
+
+VkCommandPool myUploadCommandPool = nullptr;
+VkCommandBuffer myUploadCommandBuffer = nullptr; // 正在录制的上传命令
+
+// 传输队列组的图像拷贝粒度（压缩格式以块为单位），为 0 时只能拷贝整个子资源
+VkExtent3D myTransferGranularity = { 1, 1, 1 };
+
+uint64_t myUploadSubmitted = 0; // 最后一次提交的批次令牌
+uint64_t myUploadCompleted = 0; // 已完成的批次令牌
+
+deque<UploadBatch> myUploadBatches{};
+vector<VkCommandBuffer> myUploadCommandBuffers{}; // 可复用的命令缓冲区
+
+// 传输队列组与图形队列组不同时，由图形队列获取资源所有权
+VkCommandPool myAcquireCommandPool = nullptr;
+vector<VkCommandBuffer> myAcquireCommandBuffers{};
+
+VkCommandBuffer myAcquireCommandBuffer = nullptr; // 正在录制的获取命令，之后可以追加图形队列上的上传命令
+
+// 两个命令缓冲区上排队的屏障，下一条命令之前或提交前一次记录
+BarrierBatcher myUploadBarriers{};
+BarrierBatcher myAcquireBarriers{};
+
+// ##############################################################
+
+void retireUploads(bool wait)
+{
+    // 回收 时间线已到达的批次
+    while (!myUploadBatches.empty())
+    {
+        UploadBatch& batch = myUploadBatches.front();
+
+        // 有获取命令时以图形队列为准，它在传输完成之后才执行
+        Timeline& timeline = batch.acquireValue != 0 ? myGraphicsTimeline : myTransferTimeline;
+        uint64_t value = batch.acquireValue != 0 ? batch.acquireValue : batch.token;
+
+        if (wait) waitTimeline(timeline, value);
+        else if (!isTimelineComplete(timeline, value)) break;
+
+        vkResetCommandBuffer(batch.commandBuffer, 0);
+        myUploadCommandBuffers.push_back(batch.commandBuffer);
+
+        if (batch.acquireCommandBuffer != nullptr)
+        {
+            vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+            myAcquireCommandBuffers.push_back(batch.acquireCommandBuffer);
+        }
+        myUploadCompleted = batch.token;
+
+        myUploadBatches.pop_front();
+
+        // 只等待最早的批次，其余的交给下一次轮询
+        wait = false;
+    }
+
+    // 回收 对应批次已完成的暂存区间
+    while (!myStagingRegions.empty() && myStagingRegions.front().token <= myUploadCompleted)
+    {
+        myStagingRegions.pop_front();
+    }
+}
+
+bool isUploadComplete(uint64_t token)
+{
+    retireUploads(false);
+
+    return myUploadCompleted >= token;
+}
+
+void waitUpload(uint64_t token)
+{
+    // 仅在确实需要结果时阻塞，并且只等待到指定批次
+    while (myUploadCompleted < token) retireUploads(true);
+}
+
+VkCommandBuffer beginPooledCommandBuffer(VkCommandPool commandPool, vector<VkCommandBuffer>& freeCommandBuffers)
+{
+    VkCommandBuffer commandBuffer;
+
+    if (freeCommandBuffers.empty())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(myDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) throw runtime_error("failed to allocate upload command buffer!");
+    }
+    else
+    {
+        commandBuffer = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    // 标记 命令缓冲区起点
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    return commandBuffer;
+}
+
+VkCommandBuffer getUploadCommandBuffer()
+{
+    // 所有上传命令录制到同一个命令缓冲区，直到下一次提交
+    if (myUploadCommandBuffer == nullptr) myUploadCommandBuffer = beginPooledCommandBuffer(myUploadCommandPool, myUploadCommandBuffers);
+
+    // 调用方接下来要录制命令，之前排队的屏障先记录
+    flushBarriers(myUploadBarriers, myUploadCommandBuffer);
+
+    return myUploadCommandBuffer;
+}
+
+bool needsOwnershipTransfer()
+{
+    // 独占资源在不同队列组之间使用时，必须显式转移所有权
+    return myTransferQueueFamily != myGraphicsQueueFamily;
+}
+
+VkCommandBuffer getAcquireCommandBuffer()
+{
+    // 与上传命令同一批次提交到图形队列，等待传输完成后执行
+    getUploadCommandBuffer();
+
+    if (myAcquireCommandBuffer == nullptr) myAcquireCommandBuffer = beginPooledCommandBuffer(myAcquireCommandPool, myAcquireCommandBuffers);
+
+    flushBarriers(myAcquireBarriers, myAcquireCommandBuffer);
+
+    return myAcquireCommandBuffer;
+}
+
+VkCommandBuffer getGraphicsUploadCommandBuffer()
+{
+    // 需要图形队列能力的上传命令（例如 vkCmdBlitImage），资源需要先释放给图形队列
+    return needsOwnershipTransfer() ? getAcquireCommandBuffer() : getUploadCommandBuffer();
+}
+
+BarrierBatcher& getGraphicsUploadBarriers()
+{
+    // 与 getGraphicsUploadCommandBuffer 录制到同一个命令缓冲区的屏障
+    return needsOwnershipTransfer() ? myAcquireBarriers : myUploadBarriers;
+}
+
+void releaseBuffer(VkBuffer buffer)
+{
+    // 同一队列组时由提交前的全局内存屏障保证可见性
+    if (!needsOwnershipTransfer()) return;
+
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.srcQueueFamilyIndex = myTransferQueueFamily;
+    barrier.dstQueueFamilyIndex = myGraphicsQueueFamily;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    // 释放：传输队列上只关心拷贝写入完成
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = 0;
+
+    queueBufferBarrier(myUploadBarriers, barrier);
+
+    // 获取：图形队列上让之后的读取看到写入
+    barrier.srcStageMask = const_uploadDstStageMask;
+    barrier.srcAccessMask = 0;
+    barrier.dstStageMask = const_uploadDstStageMask;
+    barrier.dstAccessMask = const_uploadDstAccessMask;
+
+    queueBufferBarrier(myAcquireBarriers, barrier);
+}
+
+void releaseImage(VkImageMemoryBarrier2 barrier)
+{
+    // 同一队列组时直接排队
+    if (!needsOwnershipTransfer())
+    {
+        queueImageBarrier(myUploadBarriers, barrier);
+        return;
+    }
+
+    // 释放与获取使用相同的布局转换，只执行一次
+    barrier.srcQueueFamilyIndex = myTransferQueueFamily;
+    barrier.dstQueueFamilyIndex = myGraphicsQueueFamily;
+
+    VkImageMemoryBarrier2 acquire = barrier;
+
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = 0;
+    queueImageBarrier(myUploadBarriers, barrier);
+
+    acquire.srcStageMask = acquire.dstStageMask;
+    acquire.srcAccessMask = 0;
+    queueImageBarrier(myAcquireBarriers, acquire);
+}
+
+uint64_t submitUploads()
+{
+    // 没有新的上传命令或屏障时返回最后一次提交的令牌
+    if (myUploadCommandBuffer == nullptr && myStagingSubmitted == myStagingHead && !hasQueuedBarriers(myUploadBarriers) && !hasQueuedBarriers(myAcquireBarriers)) return myUploadSubmitted;
+
+    // 同一队列组时，让之后的顶点、索引、统一缓冲和着色器读取看到拷贝结果
+    if (!needsOwnershipTransfer()) queueMemoryBarrier(myUploadBarriers, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, const_uploadDstStageMask, const_uploadDstAccessMask);
+
+    // 记录 所有排队的屏障
+    getUploadCommandBuffer();
+    if (hasQueuedBarriers(myAcquireBarriers)) getAcquireCommandBuffer();
+
+    // 标记 命令缓冲区终点
+    vkEndCommandBuffer(myUploadCommandBuffer);
+
+    // 批次令牌即传输队列时间线的信号值
+    UploadBatch batch{};
+    batch.token = nextTimelineValue(myTransferTimeline);
+    batch.commandBuffer = myUploadCommandBuffer;
+    myUploadSubmitted = batch.token;
+
+    // 提交到传输队列后不等待，由时间线信号量通知完成
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.token;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &myTransferTimeline.semaphore;
+
+    if (vkQueueSubmit(myTransferQueue, 1, &submitInfo, nullptr) != VK_SUCCESS) throw runtime_error("failed to submit upload command buffer!");
+
+    // 图形队列等待传输时间线到达批次令牌后获取所有权
+    if (myAcquireCommandBuffer != nullptr)
+    {
+        batch.acquireCommandBuffer = myAcquireCommandBuffer;
+        myAcquireCommandBuffer = nullptr;
+
+        vkEndCommandBuffer(batch.acquireCommandBuffer);
+
+        batch.acquireValue = nextTimelineValue(myGraphicsTimeline);
+
+        // 获取屏障的源阶段都包含在等待阶段中
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkTimelineSemaphoreSubmitInfo acquireTimelineInfo{};
+        acquireTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        acquireTimelineInfo.waitSemaphoreValueCount = 1;
+        acquireTimelineInfo.pWaitSemaphoreValues = &batch.token;
+        acquireTimelineInfo.signalSemaphoreValueCount = 1;
+        acquireTimelineInfo.pSignalSemaphoreValues = &batch.acquireValue;
+
+        VkSubmitInfo acquireInfo{};
+        acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireInfo.pNext = &acquireTimelineInfo;
+        acquireInfo.waitSemaphoreCount = 1;
+        acquireInfo.pWaitSemaphores = &myTransferTimeline.semaphore;
+        acquireInfo.pWaitDstStageMask = &waitStage;
+        acquireInfo.commandBufferCount = 1;
+        acquireInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+        acquireInfo.signalSemaphoreCount = 1;
+        acquireInfo.pSignalSemaphores = &myGraphicsTimeline.semaphore;
+
+        if (vkQueueSubmit(myGraphicsQueue, 1, &acquireInfo, nullptr) != VK_SUCCESS) throw runtime_error("failed to submit acquire command buffer!");
+    }
+
+    myUploadBatches.push_back(batch);
+    myUploadCommandBuffer = nullptr;
+
+    // 本批次使用的暂存区间在批次完成后回收
+    StagingRegion region{};
+    region.token = batch.token;
+    region.start = myStagingSubmitted;
+    myStagingRegions.push_back(region);
+
+    myStagingSubmitted = myStagingHead;
+
+    return batch.token;
+}
+
+bool tryAllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    // 环形缓冲区为空时从头开始，获得最大的连续空间
+    if (myStagingRegions.empty() && myStagingSubmitted == myStagingHead)
+    {
+        myStagingHead = 0;
+        myStagingSubmitted = 0;
+    }
+
+    bool empty = myStagingRegions.empty() && myStagingSubmitted == myStagingHead;
+    VkDeviceSize tail = myStagingRegions.empty() ? myStagingSubmitted : myStagingRegions.front().start;
+
+    VkDeviceSize aligned = alignUp(myStagingHead, alignment);
+
+    if (empty || myStagingHead > tail)
+    {
+        // 尾部剩余空间足够
+        if (aligned + size <= const_stagingBufferSize)
+        {
+            offset = aligned;
+            myStagingHead = aligned + size;
+            return true;
+        }
+
+        // 绕回到缓冲区开头
+        if (!empty && size <= tail)
+        {
+            offset = 0;
+            myStagingHead = size;
+            return true;
+        }
+    }
+    else if (myStagingHead < tail && aligned + size <= tail)
+    {
+        offset = aligned;
+        myStagingHead = aligned + size;
+        return true;
+    }
+
+    return false;
+}
+
+VkDeviceSize allocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > const_stagingBufferSize) throw runtime_error("staging allocation larger than staging buffer!");
+
+    retireUploads(false);
+
+    VkDeviceSize offset;
+    while (!tryAllocateStaging(size, alignment, offset))
+    {
+        // 剩余空间被尚未提交的数据占用时先提交，否则等待最早的批次完成
+        if (myStagingSubmitted != myStagingHead) submitUploads();
+        else retireUploads(true);
+    }
+
+    return offset;
+}
+
+// ##############################################################
+
+void createUploadContext()
+{
+    // 上传命令来自 传输队列，命令缓冲区频繁重置
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = myTransferQueueFamily;
+
+    if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myUploadCommandPool) != VK_SUCCESS) throw runtime_error("failed to create upload command pool!");
+
+    // 记录 传输队列组的图像拷贝粒度，图像分块上传时按其对齐
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(myPhysicalDevice, &queueFamilyCount, nullptr);
+
+    vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(myPhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    myTransferGranularity = queueFamilies[myTransferQueueFamily].minImageTransferGranularity;
+
+    // 获取所有权的命令来自 图形队列
+    if (needsOwnershipTransfer())
+    {
+        poolInfo.queueFamilyIndex = myGraphicsQueueFamily;
+
+        if (vkCreateCommandPool(myDevice, &poolInfo, nullptr, &myAcquireCommandPool) != VK_SUCCESS) throw runtime_error("failed to create acquire command pool!");
+    }
+
+    // 创建 暂存环形缓冲区
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = const_stagingBufferSize;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(myDevice, &bufferInfo, nullptr, &myStagingBuffer) != VK_SUCCESS) throw runtime_error("failed to create staging buffer!");
+
+    bool prefersDedicated = false;
+    VkMemoryRequirements memRequirements = getBufferMemoryRequirements(myStagingBuffer, prefersDedicated);
+
+    // 独立分配并常驻映射
+    myStagingBufferMemory = allocateMemory(memRequirements, MEMORY_USAGE_UPLOAD, true, true, VK_NULL_HANDLE, myStagingBuffer);
+
+    vkBindBufferMemory(myDevice, myStagingBuffer, myStagingBufferMemory.memory, myStagingBufferMemory.offset);
+}
+
+void destroyUploadContext()
+{
+    // 提交剩余命令并等待所有批次完成
+    waitUpload(submitUploads());
+
+    // 命令缓冲区随命令池一起释放
+    vkDestroyCommandPool(myDevice, myUploadCommandPool, nullptr);
+    myUploadCommandBuffers.clear();
+
+    if (myAcquireCommandPool != nullptr) vkDestroyCommandPool(myDevice, myAcquireCommandPool, nullptr);
+    myAcquireCommandBuffers.clear();
+
+    vkDestroyBuffer(myDevice, myStagingBuffer, nullptr);
+    freeMemory(myStagingBufferMemory);
+}
\ No newline at end of file
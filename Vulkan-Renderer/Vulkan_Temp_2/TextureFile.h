@@ -0,0 +1,312 @@
+/// <summary>
+/// 
+///  KTX2 | DDS | 块压缩格式 | 预生成多级渐远纹理
+/// 
+/// </summary>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 按优先顺序尝试的预压缩纹理文件，都不可用时回退到 PNG
+const vector<string> const_compressedTextureFiles = { "Pic0.ktx2", "Pic0.dds" };
+
+// 纹理文件中的一个层级
+struct TextureLevel
+{
+    size_t offset = 0; // 在文件数据中的偏移
+    size_t size = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// 从文件中读取、可以直接上传的纹理
+struct TextureData
+{
+    string filename;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t blockExtent = 1; // 压缩块的边长（像素）
+    uint32_t blockSize = 4; // 每个压缩块 / 像素的字节数
+
+    vector<TextureLevel> levels{};
+    vector<char> bytes{};
+};
+
+// ##############################################################
+
+bool getFormatBlock(VkFormat format, uint32_t& blockExtent, uint32_t& blockSize)
+{
+    // 获取 格式的块大小，不支持的格式返回 false
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        blockExtent = 1; blockSize = 4;
+        return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+        blockExtent = 4; blockSize = 8;
+        return true;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        blockExtent = 4; blockSize = 16;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isTextureFormatSupported(VkFormat format)
+{
+    // 检查 设备是否能以最佳排列采样该格式
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(myPhysicalDevice, format, &formatProperties);
+
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    return (formatProperties.optimalTilingFeatures & features) == features;
+}
+
+template<typename T>
+T readTextureField(const vector<char>& bytes, size_t offset)
+{
+    if (offset + sizeof(T) > bytes.size()) throw runtime_error("texture file truncated!");
+
+    T value;
+    memcpy(&value, bytes.data() + offset, sizeof(T));
+
+    return value;
+}
+
+void buildTextureLevels(TextureData& texture, uint32_t levelCount)
+{
+    // 计算 各层级的尺寸，数据按压缩块的行紧密排列
+    texture.levels.resize(levelCount);
+
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        TextureLevel& level = texture.levels[i];
+        level.width = max(texture.width >> i, 1u);
+        level.height = max(texture.height >> i, 1u);
+
+        size_t blocksWide = (level.width + texture.blockExtent - 1) / texture.blockExtent;
+        size_t blocksHigh = (level.height + texture.blockExtent - 1) / texture.blockExtent;
+        level.size = blocksWide * blocksHigh * texture.blockSize;
+    }
+}
+
+void parseKtx2(TextureData& texture)
+{
+    // KTX2 文件头：标识符 + 格式与尺寸 + 各数据段索引 + 层级索引
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    const vector<char>& bytes = texture.bytes;
+    if (bytes.size() < 80 || memcmp(bytes.data(), identifier, sizeof(identifier)) != 0) throw runtime_error("invalid KTX2 file!");
+
+    texture.format = static_cast<VkFormat>(readTextureField<uint32_t>(bytes, 12));
+    texture.width = readTextureField<uint32_t>(bytes, 20);
+    texture.height = readTextureField<uint32_t>(bytes, 24);
+
+    uint32_t pixelDepth = readTextureField<uint32_t>(bytes, 28);
+    uint32_t layerCount = readTextureField<uint32_t>(bytes, 32);
+    uint32_t faceCount = readTextureField<uint32_t>(bytes, 36);
+    uint32_t levelCount = max(readTextureField<uint32_t>(bytes, 40), 1u);
+    uint32_t supercompressionScheme = readTextureField<uint32_t>(bytes, 44);
+
+    // 只支持未超压缩的单层二维纹理
+    if (pixelDepth > 1 || layerCount > 1 || faceCount != 1) throw runtime_error("only 2D KTX2 textures are supported!");
+    if (supercompressionScheme != 0) throw runtime_error("supercompressed KTX2 textures are not supported!");
+
+    if (!getFormatBlock(texture.format, texture.blockExtent, texture.blockSize)) throw runtime_error("unsupported KTX2 format!");
+
+    buildTextureLevels(texture, levelCount);
+
+    // 层级索引：byteOffset, byteLength, uncompressedByteLength
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        size_t entry = 80 + static_cast<size_t>(i) * 24;
+
+        uint64_t byteOffset = readTextureField<uint64_t>(bytes, entry);
+        uint64_t byteLength = readTextureField<uint64_t>(bytes, entry + 8);
+
+        if (byteLength < texture.levels[i].size || byteOffset + texture.levels[i].size > bytes.size()) throw runtime_error("invalid KTX2 level index!");
+
+        texture.levels[i].offset = static_cast<size_t>(byteOffset);
+    }
+}
+
+VkFormat getDxgiFormat(uint32_t dxgiFormat)
+{
+    // DXGI_FORMAT -> VkFormat
+    switch (dxgiFormat)
+    {
+    case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+    case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+    case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+    case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+    case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+    case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+    case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+    case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+    case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+    case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+    case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+    case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+    case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+    case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+    case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+    case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+    default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+void parseDds(TextureData& texture)
+{
+    // DDS 文件头："DDS " + DDS_HEADER(124) + 可选的 DDS_HEADER_DXT10(20)
+    const vector<char>& bytes = texture.bytes;
+    if (bytes.size() < 128 || memcmp(bytes.data(), "DDS ", 4) != 0) throw runtime_error("invalid DDS file!");
+
+    texture.height = readTextureField<uint32_t>(bytes, 12);
+    texture.width = readTextureField<uint32_t>(bytes, 16);
+
+    uint32_t levelCount = max(readTextureField<uint32_t>(bytes, 28), 1u);
+    uint32_t pixelFormatFlags = readTextureField<uint32_t>(bytes, 80);
+    uint32_t caps2 = readTextureField<uint32_t>(bytes, 112);
+
+    // 立方体贴图与体积纹理不支持
+    if (caps2 & (0x200 | 0x200000)) throw runtime_error("only 2D DDS textures are supported!");
+
+    size_t dataOffset = 128;
+
+    // 压缩格式由 FourCC 给出，DX10 时由扩展头中的 DXGI 格式给出
+    if (pixelFormatFlags & 0x4)
+    {
+        char fourCC[5] = {};
+        memcpy(fourCC, bytes.data() + 84, 4);
+
+        if (strcmp(fourCC, "DX10") == 0)
+        {
+            texture.format = getDxgiFormat(readTextureField<uint32_t>(bytes, 128));
+
+            uint32_t resourceDimension = readTextureField<uint32_t>(bytes, 132);
+            uint32_t arraySize = readTextureField<uint32_t>(bytes, 140);
+            if (resourceDimension != 3 || arraySize > 1) throw runtime_error("only 2D DDS textures are supported!");
+
+            dataOffset += 20;
+        }
+        else if (strcmp(fourCC, "DXT1") == 0) texture.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        else if (strcmp(fourCC, "DXT3") == 0) texture.format = VK_FORMAT_BC2_UNORM_BLOCK;
+        else if (strcmp(fourCC, "DXT5") == 0) texture.format = VK_FORMAT_BC3_UNORM_BLOCK;
+        else if (strcmp(fourCC, "ATI1") == 0 || strcmp(fourCC, "BC4U") == 0) texture.format = VK_FORMAT_BC4_UNORM_BLOCK;
+        else if (strcmp(fourCC, "ATI2") == 0 || strcmp(fourCC, "BC5U") == 0) texture.format = VK_FORMAT_BC5_UNORM_BLOCK;
+    }
+    else if ((pixelFormatFlags & 0x40) && readTextureField<uint32_t>(bytes, 88) == 32)
+    {
+        // 未压缩的 32 位 RGBA / BGRA
+        texture.format = readTextureField<uint32_t>(bytes, 92) == 0x000000FF ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+    }
+
+    if (!getFormatBlock(texture.format, texture.blockExtent, texture.blockSize)) throw runtime_error("unsupported DDS format!");
+
+    buildTextureLevels(texture, levelCount);
+
+    // 各层级从大到小依次紧密排列
+    for (auto& level : texture.levels)
+    {
+        if (dataOffset + level.size > bytes.size()) throw runtime_error("DDS file truncated!");
+
+        level.offset = dataOffset;
+        dataOffset += level.size;
+    }
+}
+
+bool hasExtension(const string& filename, const char* extension)
+{
+    size_t length = strlen(extension);
+    return filename.size() >= length && filename.compare(filename.size() - length, length, extension) == 0;
+}
+
+bool loadTextureFile(const string& filename, TextureData& texture)
+{
+    // 只识别 .ktx2 与 .dds
+    bool ktx2 = hasExtension(filename, ".ktx2");
+    if (!ktx2 && !hasExtension(filename, ".dds"))
+    {
+        cout << "Texture " << filename << ": unknown file type, skipped" << endl;
+        return false;
+    }
+
+    // 文件不存在时返回 false，由调用方回退；文件损坏或格式不支持时抛出异常
+    ifstream file(filename, ios::ate | ios::binary);
+    if (!file.is_open()) return false;
+
+    size_t fileSize = (size_t)file.tellg();
+    texture.filename = filename;
+    texture.bytes.resize(fileSize);
+
+    file.seekg(0);
+    file.read(texture.bytes.data(), fileSize);
+    file.close();
+
+    if (ktx2) parseKtx2(texture);
+    else parseDds(texture);
+
+    return true;
+}
+
+bool loadCompressedTexture(TextureData& texture)
+{
+    // 选择第一个存在且设备支持其格式的预压缩纹理
+    for (const auto& filename : const_compressedTextureFiles)
+    {
+        TextureData candidate{};
+
+        // 单个文件损坏或不支持（例如超压缩的 KTX2、未知的 DXGI 格式）时尝试下一个，最终回退到 PNG
+        try
+        {
+            if (!loadTextureFile(filename, candidate)) continue;
+        }
+        catch (const exception& e)
+        {
+            cout << "Texture " << filename << ": " << e.what() << " skipped" << endl;
+            continue;
+        }
+
+        if (!isTextureFormatSupported(candidate.format))
+        {
+            cout << "Texture " << filename << ": format " << candidate.format << " not supported, skipped" << endl;
+            continue;
+        }
+
+        texture = move(candidate);
+        return true;
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/// <summary>
+/// 
+///  时间线信号量 | 帧节奏 | GPU 完成查询
+/// 
+/// </summary>
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// ##############################################################
+
+// 每个队列一个时间线信号量，每次提交的信号值递增
+struct Timeline
+{
+    VkSemaphore semaphore = nullptr;
+    uint64_t submitted = 0; // 最后一次提交的信号值
+    uint64_t completed = 0; // 已知完成的信号值
+};
+
+// 图形队列：每帧的绘制与上传的获取命令
+Timeline myGraphicsTimeline{};
+
+// 传输队列：上传批次，信号值即批次令牌
+Timeline myTransferTimeline{};
+
+// 每帧上一次提交时的信号值，等待到该值后这一帧的资源可以复用
+vector<uint64_t> myFrameTimelineValues{};
+
+// ##############################################################
+
+uint64_t nextTimelineValue(Timeline& timeline)
+{
+    // 调用方必须把该值放入下一次提交中
+    return ++timeline.submitted;
+}
+
+bool isTimelineComplete(Timeline& timeline, uint64_t value)
+{
+    // 已知完成时不查询设备
+    if (timeline.completed >= value) return true;
+
+    vkGetSemaphoreCounterValue(myDevice, timeline.semaphore, &timeline.completed);
+
+    return timeline.completed >= value;
+}
+
+void waitTimeline(Timeline& timeline, uint64_t value)
+{
+    if (timeline.completed >= value) return;
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline.semaphore;
+    waitInfo.pValues = &value;
+
+    if (vkWaitSemaphores(myDevice, &waitInfo, UINT64_MAX) != VK_SUCCESS) throw runtime_error("failed to wait for timeline semaphore!");
+
+    timeline.completed = max(timeline.completed, value);
+}
+
+bool isFrameComplete(uint64_t value)
+{
+    // 任何模块都可以用提交时记录的值查询 GPU 是否完成，不需要自己的栅栏
+    return isTimelineComplete(myGraphicsTimeline, value);
+}
+
+// ##############################################################
+
+void createTimeline(Timeline& timeline)
+{
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    if (vkCreateSemaphore(myDevice, &semaphoreInfo, nullptr, &timeline.semaphore) != VK_SUCCESS) throw runtime_error("failed to create timeline semaphore!");
+
+    timeline.submitted = 0;
+    timeline.completed = 0;
+}
+
+void createTimelines()
+{
+    createTimeline(myGraphicsTimeline);
+    createTimeline(myTransferTimeline);
+
+    // 值为 0 的帧视为已经完成
+    myFrameTimelineValues.assign(const_maxFrames, 0);
+}
+
+void destroyTimelines()
+{
+    vkDestroySemaphore(myDevice, myGraphicsTimeline.semaphore, nullptr);
+    vkDestroySemaphore(myDevice, myTransferTimeline.semaphore, nullptr);
+
+    myGraphicsTimeline = Timeline{};
+    myTransferTimeline = Timeline{};
+    myFrameTimelineValues.clear();
+}
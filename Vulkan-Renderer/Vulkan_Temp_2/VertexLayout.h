@@ -0,0 +1,158 @@
+/// <summary>
+/// 
+///  顶点布局反射 | 压缩顶点格式 | 半精度转换
+/// 
+/// </summary>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+// ##############################################################
+
+// 压缩的顶点分量，着色器中仍按浮点读取
+struct Half2 { uint16_t x, y; }; // 半精度浮点
+struct Unorm16x2 { uint16_t x, y; }; // [0, 1] 映射到 0 ~ 65535
+struct Unorm8x4 { uint8_t r, g, b, a; }; // [0, 1] 映射到 0 ~ 255
+
+// 成员类型 -> 顶点格式
+template<typename T> struct VertexFormat;
+
+template<> struct VertexFormat<glm::vec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; };
+template<> struct VertexFormat<glm::vec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; };
+template<> struct VertexFormat<glm::vec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; };
+template<> struct VertexFormat<Half2> { static constexpr VkFormat format = VK_FORMAT_R16G16_SFLOAT; };
+template<> struct VertexFormat<Unorm16x2> { static constexpr VkFormat format = VK_FORMAT_R16G16_UNORM; };
+template<> struct VertexFormat<Unorm8x4> { static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM; };
+
+// 单个顶点属性，location 为在属性列表中的序号
+struct VertexAttribute
+{
+    uint32_t offset;
+    VkFormat format;
+};
+
+// 由成员推导偏移与格式
+#define VERTEX_ATTRIBUTE(vertex, member) VertexAttribute{ static_cast<uint32_t>(offsetof(vertex, member)), VertexFormat<decltype(vertex::member)>::format }
+
+// 每种顶点类型特化一次，提供 attributes 数组
+template<typename V> struct VertexLayout;
+
+// ##############################################################
+
+template<typename V>
+constexpr VkVertexInputBindingDescription getVertexBindingDescription(uint32_t binding = 0)
+{
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = binding;
+    bindingDescription.stride = sizeof(V);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescription;
+}
+
+template<typename V>
+constexpr auto getVertexAttributeDescriptions(uint32_t binding = 0)
+{
+    constexpr auto& attributes = VertexLayout<V>::attributes;
+
+    array<VkVertexInputAttributeDescription, attributes.size()> attributeDescriptions{};
+    for (size_t i = 0; i < attributes.size(); i++)
+    {
+        attributeDescriptions[i].binding = binding;
+        attributeDescriptions[i].location = static_cast<uint32_t>(i);
+        attributeDescriptions[i].format = attributes[i].format;
+        attributeDescriptions[i].offset = attributes[i].offset;
+    }
+
+    return attributeDescriptions;
+}
+
+template<typename V>
+bool matchesVertexLayout(const MeshView& mesh)
+{
+    // 网格文件的顶点布局与顶点类型一致时可以直接使用
+    constexpr auto attributeDescriptions = getVertexAttributeDescriptions<V>();
+
+    if (mesh.header->vertexStride != sizeof(V) || mesh.header->attributeCount != attributeDescriptions.size()) return false;
+
+    for (size_t i = 0; i < attributeDescriptions.size(); i++)
+    {
+        const MeshAttribute& attribute = mesh.attributes[i];
+
+        if (attribute.location != attributeDescriptions[i].location || attribute.format != static_cast<uint32_t>(attributeDescriptions[i].format) || attribute.offset != attributeDescriptions[i].offset) return false;
+    }
+
+    return true;
+}
+
+// ##############################################################
+
+uint16_t floatToHalf(float value)
+{
+    // 就近舍入到偶数，超出范围时为无穷大
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t absBits = bits & 0x7FFFFFFF;
+
+    // 溢出、无穷大 与 NaN
+    if (absBits >= 0x47800000) return static_cast<uint16_t>(sign | (absBits > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+    // 非规格化数，按 2^-24 为单位取整
+    if (absBits < 0x38800000)
+    {
+        float absValue;
+        memcpy(&absValue, &absBits, sizeof(absValue));
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(lrintf(absValue * 16777216.0f)));
+    }
+
+    // 规格化数：指数偏移从 127 调整为 15，尾数舍入到 10 位
+    absBits += 0xC8000FFF + ((absBits >> 13) & 1);
+    return static_cast<uint16_t>(sign | (absBits >> 13));
+}
+
+#ifdef USE_SSE2
+__m128i floatToHalf4(__m128 value)
+{
+    // 与 floatToHalf 相同的转换，一次处理 4 个值，结果在每个 32 位通道的低 16 位
+    const __m128i halfMax = _mm_set1_epi32(0x47800000);
+    const __m128i minNormal = _mm_set1_epi32(0x38800000);
+    const __m128i subnormalMagic = _mm_set1_epi32(0x3F000000); // 0.5，加上后尾数低位即为非规格化结果
+
+    __m128 sign = _mm_and_ps(value, _mm_set1_ps(-0.0f));
+    __m128 absValue = _mm_xor_ps(value, sign);
+    __m128i absBits = _mm_castps_si128(absValue);
+
+    // 溢出、无穷大 与 NaN
+    __m128i isNan = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(0x7F800000));
+    __m128i isRegular = _mm_cmpgt_epi32(halfMax, absBits);
+    __m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+
+    // 非规格化数，借助浮点加法完成舍入
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+    // 规格化数
+    __m128i odd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+    __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(static_cast<int32_t>(0xC8000FFF))), odd), 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    __m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+
+    return _mm_or_si128(result, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+uint16_t floatToUnorm16(float value)
+{
+    return static_cast<uint16_t>(lrintf(min(max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+uint8_t floatToUnorm8(float value)
+{
+    return static_cast<uint8_t>(lrintf(min(max(value, 0.0f), 1.0f) * 255.0f));
+}
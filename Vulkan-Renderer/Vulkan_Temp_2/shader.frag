@@ -1,5 +1,9 @@
 #version 450
 
+layout(constant_id = 0) const float UV_SCALE = 2.0;
+layout(constant_id = 1) const bool USE_TEXTURE = true;
+layout(constant_id = 2) const bool USE_VERTEX_COLOR = false;
+
 layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) in vec3 fragColor;
@@ -8,5 +12,9 @@ layout(location = 1) in vec2 fragTexCoord;
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord * 2);
+    vec4 color = vec4(1.0);
+    if (USE_TEXTURE) color = texture(texSampler, fragTexCoord * UV_SCALE);
+    if (USE_VERTEX_COLOR) color.rgb *= fragColor;
+
+    outColor = color;
 }
\ No newline at end of file
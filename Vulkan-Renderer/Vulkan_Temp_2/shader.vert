@@ -1,11 +1,17 @@
 #version 450
 
+layout(constant_id = 3) const bool USE_MODEL_MATRIX = true;
+
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    uint materialIndex;
+} object;
+
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
@@ -14,7 +20,10 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+    vec4 position = vec4(inPosition, 0.0, 1.0);
+    if (USE_MODEL_MATRIX) position = object.model * position;
+
+    gl_Position = ubo.proj * ubo.view * position;
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 }
\ No newline at end of file
@@ -1,23 +1,38 @@
-// Vulkan
+// Vulkan库
 #include <vulkan/vulkan.h>
 
-// GLFW
+// GLFW库
 #include <GLFW/glfw3.h>
 
-// GLM
+// GLM库
 #include <glm/glm.hpp>
 
-// STB
+// STB库
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-// C++
+// C++库
 #include <iostream>
 
-// Զ
+// 自定义库
 #include "Base.h"
 #include "Func0.h"
 #include "Func1.h"
+#include "Timeline.h"
+#include "Barriers.h"
+#include "Memory.h"
+#include "Staging.h"
+#include "Mipmap.h"
+#include "TextureFile.h"
+#include "Decode.h"
+#include "Mesh.h"
+#include "VertexLayout.h"
+#include "PipelineCache.h"
+#include "Shaders.h"
+#include "Pipeline.h"
+#include "Descriptor.h"
+#include "Recording.h"
+#include "RenderGraph.h"
 #include "Func2.h"
 #include "Func3.h"
 
@@ -39,7 +54,7 @@ public:
         int width = 0, height = 0;
         glfwGetFramebufferSize(myWindow, &width, &height);
 
-        // Сʱͣ
+        // 窗口最小化时暂停
         while (width == 0 || height == 0)
         {
             glfwGetFramebufferSize(myWindow, &width, &height);
@@ -48,12 +63,17 @@ public:
 
         vkDeviceWaitIdle(myDevice);
 
-        // ´ڵ´
+        // 根据新窗口的数据重新创建交换链
         cleanupSwapChain();
 
         createSwapChain();
         createImageViews();
-        createFramebuffers();
+
+        // 动态渲染直接使用新的图像视图，没有帧缓冲区需要重建
+        if (!myDynamicRenderingEnabled) createFramebuffers();
+
+        // 缓存的命令缓冲区引用了旧的交换链图像，全部重新录制
+        resetCommandBufferCache();
     }
 
 private:
@@ -61,190 +81,261 @@ private:
 
     void initWindow()
     {
-        // ʼ GLFW
+        // 初始化 GLFW库
         glfwInit();
 
-        // ô
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // ʹͼAPI
+        // 设置窗口
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // 不使用图形API
 
-        // 
+        // 创建窗口
         myWindow = glfwCreateWindow(const_width, const_height, "Vulkan", nullptr, nullptr);
 
-        // 
+        // 关联窗口
         glfwSetWindowUserPointer(myWindow, this);
 
-        // ûص
+        // 设置回调
         glfwSetFramebufferSizeCallback(myWindow, framebufferResizeCallback);
     }
 
     void initVulkan()
     {
-        //  Vulkanʵ
+        auto startupStart = chrono::high_resolution_clock::now();
+
+        // 创建 解码线程，图像解码与之后的初始化并行进行
+        createDecodeWorkers();
+        requestDecode("Pic0.png");
+
+        // 创建 Vulkan实例
         createVulkanInstance();
 
-        //  
+        // 创建 表面对象
         createSurface();
 
-        // ѡ 豸
+        // 选择 物理设备
         pickPhysicalDevice();
 
-        //  ߼豸
+        // 创建 内存分配器，缓存内存属性
+        createMemoryAllocator();
+
+        // 创建 逻辑设备
         createLogicalDevice();
 
-        //  
+        // 创建 图形队列与传输队列的时间线信号量
+        createTimelines();
+
+        // 创建 管线缓存，读取上次运行保存的数据
+        createPipelineCache();
+
+        // 创建 交换链条
         createSwapChain();
 
-        //  ͼͼ
+        // 创建 图像视图
         createImageViews();
 
-        //  
+        // 创建 描述布局
         createDescriptorSetLayout();
 
-        //  Ⱦͨ
-        createRenderPass();
+        // 创建 描述集更新模板
+        createDescriptorUpdateTemplate();
 
-        //  Ⱦ
+        // 创建 渲染通道，动态渲染时不需要
+        if (!myDynamicRenderingEnabled) createRenderPass();
+
+        // 创建 渲染管线
         createGraphicsPipeline();
 
-        //  ֡
-        createFramebuffers();
+        // 创建 帧缓冲区，动态渲染时不需要
+        if (!myDynamicRenderingEnabled) createFramebuffers();
 
-        //  
+        // 创建 命令池
         createCommandPool();
 
-        //  ͼ
+        // 创建 上传批次与暂存环形缓冲区
+        createUploadContext();
+
+        // 创建 纹理图像
         createTextureImage();
 
-        //  ͼͼ
+        // 创建 图像视图
         createTextureImageView();
 
-        //  ͼ
+        // 创建 图像采样器
         createTextureSampler();
 
-        //  㻺
+        // 映射 网格文件
+        openMeshFile();
+
+        // 创建 顶点缓冲区
         createVertexBuffer();
 
-        //  
+        // 创建 索引缓冲区
         createIndexBuffer();
 
-        //  ͳһ
-        createUniformBuffers();
+        // 解除 网格文件映射，数据已经写入暂存区
+        closeMeshFile();
 
-        //  
-        createDescriptorPool();
+        // 所有资源的上传命令一次提交，与绘制在同一队列上按顺序执行，无需等待
+        submitUploads();
+
+        // 创建 统一缓冲区
+        createUniformBuffers();
 
-        //  
+        // 创建 描述集
         createDescriptorSets();
 
-        //  
+        // 创建 命令缓冲区
         createCommandBuffer();
 
-        //  ͬ
+        // 创建 录制线程与每帧每个线程的命令池
+        createRecordContext();
+
+        // 创建 复用的命令缓冲区的命令池
+        createCommandBufferCache();
+
+        // 创建 同步物体
         createSyncObjects();
+
+        // 输出 内存分配统计
+        printMemoryStatistics();
+
+        // 输出 描述集缓存统计
+        printDescriptorStatistics();
+
+        // 输出 资源加载耗时
+        printAssetTimings();
+
+        // 输出 启动耗时
+        printStartupTime(elapsedMs(startupStart));
     }
 
     void mainLoop()
     {
         while (!glfwWindowShouldClose(myWindow))
         {
-            // ¼
+            // 处理窗口事件
             glfwPollEvents();
 
-            // Ⱦÿһ֡
+            // 渲染每一帧
             drawFrame();
         }
 
         vkDeviceWaitIdle(myDevice);
+
+        // 输出 命令缓冲区复用统计
+        printCommandBufferStatistics();
     }
 
     void cleanup()
     {
-        //  
+        // 销毁 交换链相关
         cleanupSwapChain();
 
-        //  Ⱦ
-        vkDestroyPipeline(myDevice, myGraphicsPipeline, nullptr);
+        // 销毁 所有渲染管线
+        destroyPipelines();
+
+        // 写回并销毁 管线缓存
+        destroyPipelineCache();
 
-        //  ߲
+        // 销毁 管线布局
         vkDestroyPipelineLayout(myDevice, myPipelineLayout, nullptr);
 
-        //  Ⱦͨ
+        // 销毁 渲染通道
         vkDestroyRenderPass(myDevice, myRenderPass, nullptr);
 
-        //  ֡Ļڴ
+        // 销毁 多个帧的缓冲区和内存
         for (size_t i = 0; i < const_maxFrames; i++)
         {
             vkDestroyBuffer(myDevice, myUniformBuffers[i], nullptr);
-            vkFreeMemory(myDevice, myUniformBuffersMemory[i], nullptr);
+            freeMemory(myUniformBuffersMemory[i]);
         }
 
-        //  
-        vkDestroyDescriptorPool(myDevice, myDescriptorPool, nullptr);
+        // 销毁 描述集缓存的所有描述池
+        destroyDescriptorCache();
 
-        //  
+        // 销毁 描述集更新模板
+        vkDestroyDescriptorUpdateTemplate(myDevice, myDescriptorUpdateTemplate, nullptr);
+
+        // 销毁 描述布局
         vkDestroyDescriptorSetLayout(myDevice, myDescriptorSetLayout, nullptr);
 
-        //  
+        // 销毁 索引缓冲区
         vkDestroyBuffer(myDevice, myIndexBuffer, nullptr);
 
-        // ͷ ڴ
-        vkFreeMemory(myDevice, myIndexBufferMemory, nullptr);
+        // 释放 索引缓冲区内存
+        freeMemory(myIndexBufferMemory);
 
-        //  㻺
+        // 销毁 顶点缓冲区
         vkDestroyBuffer(myDevice, myVertexBuffer, nullptr);
 
-        // ͷ 㻺ڴ
-        vkFreeMemory(myDevice, myVertexBufferMemory, nullptr);
+        // 释放 顶点缓冲区内存
+        freeMemory(myVertexBufferMemory);
 
-        //  ͼ
+        // 销毁 图像采样器
         vkDestroySampler(myDevice, myTextureSampler, nullptr);
 
-        //  ͼͼ
+        // 销毁 图像视图
         vkDestroyImageView(myDevice, myTextureImageView, nullptr);
 
-        //  ͼ񻺳
+        // 销毁 图像缓冲区
         vkDestroyImage(myDevice, myTextureImage, nullptr);
 
-        // ͷ ͼ񻺳ڴ
-        vkFreeMemory(myDevice, myTextureImageMemory, nullptr);
+        // 释放 图像缓冲区内存
+        freeMemory(myTextureImageMemory);
 
-        //  ź
+        // 销毁 信号量
         for (int num = 0; num < const_maxFrames; num++)
         {
             vkDestroySemaphore(myDevice, myRenderFinishedSemaphores[num], nullptr);
             vkDestroySemaphore(myDevice, myImageAvailableSemaphores[num], nullptr);
-            vkDestroyFence(myDevice, myInFlightFences[num], nullptr);
         }
 
-        //  
-        vkDestroyCommandPool(myDevice, myCommandPool, nullptr);
+        // 销毁 上传批次与暂存环形缓冲区
+        destroyUploadContext();
+
+        // 销毁 时间线信号量
+        destroyTimelines();
+
+        // 停止 录制线程并销毁它们的命令池
+        destroyRecordContext();
+
+        // 销毁 复用的命令缓冲区的命令池
+        destroyCommandBufferCache();
 
-        //  ߼豸
+        // 销毁 命令池
+        for (auto commandPool : myCommandPools) vkDestroyCommandPool(myDevice, commandPool, nullptr);
+
+        // 释放 所有内存块
+        destroyMemoryAllocator();
+
+        // 销毁 逻辑设备引用
         vkDestroyDevice(myDevice, nullptr);
 
-        //  
+        // 销毁 表面对象
         vkDestroySurfaceKHR(myVulkanInstance, mySurface, nullptr);
 
-        //  Vulkan ʵ
+        // 销毁 Vulkan 实例
         vkDestroyInstance(myVulkanInstance, nullptr);
 
-        //  GLFW 
+        // 销毁 GLFW 窗口
         glfwDestroyWindow(myWindow);
 
-        // ͷ GLFW 
+        // 释放 GLFW 库
         glfwTerminate();
+
+        // 销毁 解码线程
+        destroyDecodeWorkers();
     }
 
     void drawFrame()
     {
-        // ȴһ֡
-        vkWaitForFences(myDevice, 1, &myInFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        // 等待 这一帧上一次提交的命令完成
+        waitTimeline(myGraphicsTimeline, myFrameTimelineValues[currentFrame]);
 
-        // ӽһͼ
+        // 从交换链请求下一张图像
         uint32_t imageIndex;
         VkResult result = vkAcquireNextImageKHR(myDevice, mySwapChain, UINT64_MAX, myImageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
-        // ڱ仯ʱ´
+        // 当窗口变化时，重新创建交换链
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
             recreateSwapChain();
@@ -252,17 +343,13 @@ private:
         }
         else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) throw runtime_error("failed to acquire swap chain image!");
 
-        //  ͳһ
+        // 更新 统一缓冲区
         updateUniformBuffer(currentFrame);
 
-        // դź
-        vkResetFences(myDevice, 1, &myInFlightFences[currentFrame]);
-
-        // ò¼
-        vkResetCommandBuffer(myCommandBuffers[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
-        recordCommandBuffer(myCommandBuffers[currentFrame], imageIndex);
+        // 获取 这一帧的命令缓冲区，内容变化时才重新录制
+        VkCommandBuffer commandBuffer = getFrameCommandBuffer(currentFrame, imageIndex);
 
-        // ύ
+        // 提交命令缓冲区
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -273,18 +360,35 @@ private:
         submitInfo.pWaitDstStageMask = waitStages;
 
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &myCommandBuffers[currentFrame];
+        submitInfo.pCommandBuffers = &commandBuffer;
 
-        VkSemaphore signalSemaphores[] = { myRenderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
+        // 同时触发演示用的二值信号量与图形队列时间线
+        uint64_t frameValue = nextTimelineValue(myGraphicsTimeline);
+
+        VkSemaphore signalSemaphores[] = { myRenderFinishedSemaphores[currentFrame], myGraphicsTimeline.semaphore };
+        submitInfo.signalSemaphoreCount = 2;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        if (vkQueueSubmit(myGraphicsQueue, 1, &submitInfo, myInFlightFences[currentFrame]) != VK_SUCCESS)
+        // 二值信号量忽略对应的值
+        uint64_t waitValues[] = { 0 };
+        uint64_t signalValues[] = { 0, frameValue };
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = 1;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+        timelineInfo.signalSemaphoreValueCount = 2;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+        submitInfo.pNext = &timelineInfo;
+
+        if (vkQueueSubmit(myGraphicsQueue, 1, &submitInfo, nullptr) != VK_SUCCESS)
         {
             throw runtime_error("failed to submit draw command buffer!");
         }
 
-        // ؽ
+        myFrameTimelineValues[currentFrame] = frameValue;
+
+        // 将结果返回交换链
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -299,7 +403,7 @@ private:
 
         result = vkQueuePresentKHR(myPresentQueue, &presentInfo);
 
-        // ڱ仯ʱ´
+        // 当窗口变化时，重新创建交换链
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) 
         {
             framebufferResized = false;
@@ -307,7 +411,7 @@ private:
         }
         else if (result != VK_SUCCESS) throw runtime_error("failed to present swap chain image!");
 
-        // Ⱦһ֡
+        // 渲染下一帧
         currentFrame = (currentFrame + 1) % const_maxFrames;
     }
 